@@ -0,0 +1,77 @@
+#---------------------------------------------------------------------------------
+# Host build of the headless tools, included by the Makefile for "make host" and
+# "make host-clean".
+#
+# Builds the engine and the emulation layer with the build machine's compiler,
+# together with the command line front ends in source/Host. Nothing here uses
+# libctru or SDL, so DEVKITARM is not needed.
+#
+# smb-batch: the batch runner scaling benchmark and the area parser benchmark
+# smb-verify: records native routine calls and replays them through both the
+#   decompiled and the native code (built with SMB_VERIFY_NATIVE)
+#
+# HOST_CXX: the compiler to use (default: c++)
+#---------------------------------------------------------------------------------
+HOST_CXX	?=	c++
+HOST_BUILD	:=	build-host
+
+HOST_ENGINE	:=	source/Configuration.cpp \
+			$(wildcard source/SMB/*.cpp) \
+			$(wildcard source/Emulation/*.cpp) \
+			source/Util/RomImage.cpp
+
+HOST_BATCH_SOURCES	:=	$(HOST_ENGINE) \
+			source/Util/AreaCache.cpp \
+			source/Util/AreaParserBenchmark.cpp \
+			source/Util/BatchRunner.cpp \
+			source/Util/Timer.cpp \
+			source/Host/BatchMain.cpp
+HOST_VERIFY_SOURCES	:=	$(HOST_ENGINE) \
+			source/Host/VerifyMain.cpp
+
+HOST_CXXFLAGS	:=	-Wall -g -O3 -std=gnu++17 -fno-rtti -fno-exceptions -Isource -MMD -MP
+HOST_LDFLAGS	:=	-g
+HOST_LIBS	:=	-lpthread
+
+ifneq ($(strip $(LTO)),)
+HOST_CXXFLAGS	+=	-flto
+HOST_LDFLAGS	+=	-flto
+endif
+
+HOST_BATCH_OFILES	:=	$(patsubst source/%.cpp,$(HOST_BUILD)/batch/%.o,$(HOST_BATCH_SOURCES))
+HOST_VERIFY_OFILES	:=	$(patsubst source/%.cpp,$(HOST_BUILD)/verify/%.o,$(HOST_VERIFY_SOURCES))
+
+.PHONY: host host-clean
+
+#---------------------------------------------------------------------------------
+host: smb-batch smb-verify
+
+smb-batch: $(HOST_BATCH_OFILES)
+	@echo linking $(notdir $@)
+	@$(HOST_CXX) $(HOST_LDFLAGS) -o $@ $^ $(HOST_LIBS)
+
+smb-verify: $(HOST_VERIFY_OFILES)
+	@echo linking $(notdir $@)
+	@$(HOST_CXX) $(HOST_LDFLAGS) -o $@ $^ $(HOST_LIBS)
+
+$(HOST_BUILD)/batch/%.o: source/%.cpp
+	@mkdir -p $(dir $@)
+	@echo $(notdir $<)
+	@$(HOST_CXX) $(HOST_CXXFLAGS) -c $< -o $@
+
+$(HOST_BUILD)/verify/%.o: source/%.cpp
+	@mkdir -p $(dir $@)
+	@echo $(notdir $<) "(verify)"
+	@$(HOST_CXX) $(HOST_CXXFLAGS) -DSMB_VERIFY_NATIVE -c $< -o $@
+
+#---------------------------------------------------------------------------------
+# same reason as the SMB.o rule in the Makefile
+#---------------------------------------------------------------------------------
+$(HOST_BUILD)/batch/SMB/SMB.o $(HOST_BUILD)/verify/SMB/SMB.o	:	HOST_CXXFLAGS += -fno-tree-pta
+
+#---------------------------------------------------------------------------------
+host-clean:
+	@echo clean host ...
+	@rm -fr $(HOST_BUILD) smb-batch smb-verify
+
+-include $(HOST_BATCH_OFILES:.o=.d) $(HOST_VERIFY_OFILES:.o=.d)
@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <fstream>
 
 #include "Configuration.hpp"
@@ -6,16 +7,38 @@
  * List of all supported configuration options.
  */
 std::list<ConfigurationOption*> Configuration::configurationOptions = {
+    &Configuration::audioBufferSamples,
     &Configuration::audioEnabled,
     &Configuration::audioFrequency,
+    &Configuration::audioRenderFrames,
+    &Configuration::audioRenderFileName,
+    &Configuration::audioReplayFileName,
+    &Configuration::audioStereo,
+    &Configuration::audioTraceFileName,
+    &Configuration::batchAreaCacheFileName,
+    &Configuration::batchAreaParser,
+    &Configuration::batchFrames,
+    &Configuration::batchInstances,
     &Configuration::frameRate,
+    &Configuration::frameSkip,
+    &Configuration::inputPlayer1,
+    &Configuration::inputPlayer2,
     &Configuration::paletteFileName,
     &Configuration::renderScale,
+    &Configuration::renderThreadEnabled,
     &Configuration::romFileName,
+    &Configuration::runAheadFrames,
     &Configuration::scanlinesEnabled,
     &Configuration::vsyncEnabled
 };
 
+/**
+ * Number of samples in the audio device buffer. Smaller buffers lower latency but may crackle.
+ */
+BasicConfigurationOption<int> Configuration::audioBufferSamples(
+    "audio.buffer_samples", 1024
+);
+
 /**
  * Whether audio is enabled or not.
  */
@@ -30,6 +53,69 @@ BasicConfigurationOption<int> Configuration::audioFrequency(
     "audio.frequency", 48000
 );
 
+/**
+ * Number of frames to emulate when rendering audio to a file.
+ */
+BasicConfigurationOption<int> Configuration::audioRenderFrames(
+    "audio.render_frames", 3600
+);
+
+/**
+ * WAV file to render audio to, without video. Empty to run the game normally.
+ */
+BasicConfigurationOption<std::string> Configuration::audioRenderFileName(
+    "audio.render_file", ""
+);
+
+/**
+ * APU trace to replay instead of running the game when rendering audio to a file.
+ */
+BasicConfigurationOption<std::string> Configuration::audioReplayFileName(
+    "audio.replay_file", ""
+);
+
+/**
+ * Whether audio is panned into stereo or mixed to mono.
+ */
+BasicConfigurationOption<bool> Configuration::audioStereo(
+    "audio.stereo", false
+);
+
+/**
+ * File to record APU register writes to. Empty to disable tracing.
+ */
+BasicConfigurationOption<std::string> Configuration::audioTraceFileName(
+    "audio.trace_file", ""
+);
+
+/**
+ * File the decoded areas are cached in, built on the first run if missing. Empty to disable.
+ */
+BasicConfigurationOption<std::string> Configuration::batchAreaCacheFileName(
+    "batch.area_cache", ""
+);
+
+/**
+ * Whether to run the area parser benchmark instead of the game.
+ */
+BasicConfigurationOption<bool> Configuration::batchAreaParser(
+    "batch.area_parser", false
+);
+
+/**
+ * Number of frames each engine runs in the batch scaling benchmark.
+ */
+BasicConfigurationOption<int> Configuration::batchFrames(
+    "batch.frames", 600
+);
+
+/**
+ * Number of engines in the batch scaling benchmark. 0 to run the game normally.
+ */
+BasicConfigurationOption<int> Configuration::batchInstances(
+    "batch.instances", 0
+);
+
 /**
  * Frame rate (per second).
  */
@@ -37,6 +123,28 @@ BasicConfigurationOption<int> Configuration::frameRate(
     "game.frame_rate", 60
 );
 
+/**
+ * Number of frames to skip rendering after each rendered frame.
+ */
+BasicConfigurationOption<int> Configuration::frameSkip(
+    "video.frameskip", 0
+);
+
+/**
+ * Key mapping for the player 1 controller, as space separated "KEY:BUTTON" pairs.
+ */
+BasicConfigurationOption<std::string> Configuration::inputPlayer1(
+    "input.player1",
+    "A:A B:B SELECT:SELECT START:START DUP:UP DDOWN:DOWN DLEFT:LEFT DRIGHT:RIGHT"
+);
+
+/**
+ * Key mapping for the player 2 controller. Empty to leave player 2 unmapped.
+ */
+BasicConfigurationOption<std::string> Configuration::inputPlayer2(
+    "input.player2", ""
+);
+
 /**
  * The filename for a custom palette to use for rendering.
  */
@@ -51,6 +159,13 @@ BasicConfigurationOption<int> Configuration::renderScale(
     "video.scale", 1
 );
 
+/**
+ * Whether frames are rendered on another core while the next frame is updated.
+ */
+BasicConfigurationOption<bool> Configuration::renderThreadEnabled(
+    "video.render_thread", true
+);
+
 /**
  * Filename for the SMB ROM image.
  */
@@ -58,6 +173,13 @@ BasicConfigurationOption<std::string> Configuration::romFileName(
     "game.rom_file", "sdmc:/3ds/SMB/Super Mario Bros. (JU) (PRG0) [!].nes"
 );
 
+/**
+ * Number of frames to run ahead of the displayed frame to hide input lag.
+ */
+BasicConfigurationOption<int> Configuration::runAheadFrames(
+    "game.run_ahead", 0
+);
+
 /**
  * Whether scanlines are enabled or not.
  */
@@ -83,27 +205,146 @@ const std::string& ConfigurationOption::getPath() const
     return path;
 }
 
+/**
+ * Remove leading and trailing whitespace from a string, in place.
+ */
+static void trim(std::string& text)
+{
+    size_t end = text.find_last_not_of(" \t\r\n");
+    if (end == std::string::npos)
+    {
+        text.clear();
+        return;
+    }
+    text.erase(end + 1);
+    text.erase(0, text.find_first_not_of(" \t"));
+}
+
+bool parseConfigurationValue(const std::string& text, bool& value)
+{
+    if (text == "true" || text == "yes" || text == "on" || text == "1")
+    {
+        value = true;
+        return true;
+    }
+    if (text == "false" || text == "no" || text == "off" || text == "0")
+    {
+        value = false;
+        return true;
+    }
+    return false;
+}
+
+bool parseConfigurationValue(const std::string& text, int& value)
+{
+    char* end;
+    long parsed = strtol(text.c_str(), &end, 0);
+    if (text.empty() || *end != '\0')
+    {
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+bool parseConfigurationValue(const std::string& text, std::string& value)
+{
+    // Allow values to be quoted, so they can have leading or trailing spaces
+    //
+    if (text.size() >= 2 && text.front() == '"' && text.back() == '"')
+    {
+        value = text.substr(1, text.size() - 2);
+    }
+    else
+    {
+        value = text;
+    }
+    return true;
+}
+
 void Configuration::initialize(const std::string& fileName)
 {
     // Check that the configuration file exists.
     // If it does not exist, we will fall back to default values.
     //
-    /*std::ifstream configFile(fileName.c_str());
+    std::ifstream configFile(fileName.c_str());
+    if (!configFile.good())
+    {
+        return;
+    }
+
+    // Read the file one line at a time, reusing the same strings for every line.
+    // Lines are "[section]" headers, "key = value" pairs, or comments starting with ';' or '#'.
+    //
+    std::string line;
+    std::string path;
+    std::string value;
+    size_t sectionLength = 0;
+    int lineNumber = 0;
 
-    if (configFile.good())
+    while (std::getline(configFile, line))
     {
-        // Load the configuration file into a property tree to parse it
-        //
-        //boost::property_tree::ptree propertyTree;
-        //boost::property_tree::ini_parser::read_ini(configFile, propertyTree);
+        lineNumber++;
+        trim(line);
+        if (line.empty() || line[0] == ';' || line[0] == '#')
+        {
+            continue;
+        }
+
+        if (line[0] == '[')
+        {
+            size_t close = line.find(']');
+            if (close == std::string::npos)
+            {
+                std::cout << fileName << ":" << lineNumber << ": unterminated section header" << std::endl;
+                continue;
+            }
+            path.assign(line, 1, close - 1);
+            trim(path);
+            if (!path.empty())
+            {
+                path += '.';
+            }
+            sectionLength = path.size();
+            continue;
+        }
+
+        size_t separator = line.find('=');
+        if (separator == std::string::npos)
+        {
+            std::cout << fileName << ":" << lineNumber << ": expected \"key = value\"" << std::endl;
+            continue;
+        }
 
-        // Try to load the value for all known config options
+        // The option path is "section.key"
         //
+        path.resize(sectionLength);
+        path.append(line, 0, separator);
+        trim(path);
+        value.assign(line, separator + 1, std::string::npos);
+        trim(value);
+
+        bool found = false;
         for (auto option : configurationOptions)
         {
-            option->initializeValue(propertyTree);
+            if (option->getPath() == path)
+            {
+                option->initializeValue(value);
+                found = true;
+                break;
+            }
         }
-    }*/
+
+        if (!found)
+        {
+            std::cout << fileName << ":" << lineNumber << ": unknown configuration option \"" << path << "\"" << std::endl;
+        }
+    }
+}
+
+int Configuration::getAudioBufferSamples()
+{
+    return audioBufferSamples.getValue();
 }
 
 bool Configuration::getAudioEnabled()
@@ -116,11 +357,71 @@ int Configuration::getAudioFrequency()
     return audioFrequency.getValue();
 }
 
+int Configuration::getAudioRenderFrames()
+{
+    return audioRenderFrames.getValue();
+}
+
+const std::string& Configuration::getAudioRenderFileName()
+{
+    return audioRenderFileName.getValue();
+}
+
+const std::string& Configuration::getAudioReplayFileName()
+{
+    return audioReplayFileName.getValue();
+}
+
+bool Configuration::getAudioStereo()
+{
+    return audioStereo.getValue();
+}
+
+const std::string& Configuration::getAudioTraceFileName()
+{
+    return audioTraceFileName.getValue();
+}
+
+const std::string& Configuration::getBatchAreaCacheFileName()
+{
+    return batchAreaCacheFileName.getValue();
+}
+
+bool Configuration::getBatchAreaParser()
+{
+    return batchAreaParser.getValue();
+}
+
+int Configuration::getBatchFrames()
+{
+    return batchFrames.getValue();
+}
+
+int Configuration::getBatchInstances()
+{
+    return batchInstances.getValue();
+}
+
 int Configuration::getFrameRate()
 {
     return frameRate.getValue();
 }
 
+int Configuration::getFrameSkip()
+{
+    return frameSkip.getValue();
+}
+
+const std::string& Configuration::getInputPlayer1()
+{
+    return inputPlayer1.getValue();
+}
+
+const std::string& Configuration::getInputPlayer2()
+{
+    return inputPlayer2.getValue();
+}
+
 const std::string& Configuration::getPaletteFileName()
 {
     return paletteFileName.getValue();
@@ -131,11 +432,31 @@ int Configuration::getRenderScale()
     return renderScale.getValue();
 }
 
+bool Configuration::getRenderThreadEnabled()
+{
+    return renderThreadEnabled.getValue();
+}
+
+RuntimeConfig Configuration::getRuntimeConfig()
+{
+    RuntimeConfig config;
+    config.audioEnabled = audioEnabled.getValue();
+    config.audioFrequency = audioFrequency.getValue();
+    config.frameRate = frameRate.getValue();
+    config.computeDerivedValues();
+    return config;
+}
+
 const std::string& Configuration::getRomFileName()
 {
     return romFileName.getValue();
 }
 
+int Configuration::getRunAheadFrames()
+{
+    return runAheadFrames.getValue();
+}
+
 bool Configuration::getScanlinesEnabled()
 {
     return scanlinesEnabled.getValue();
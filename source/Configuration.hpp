@@ -5,8 +5,14 @@
 #include <list>
 #include <string>
 
-//#include <boost/property_tree/ptree.hpp>
-//#include <boost/property_tree/ini_parser.hpp>
+/**
+ * Parse the text of a configuration value.
+ *
+ * @return false if the text is not a valid value of the type; the value is left unchanged.
+ */
+bool parseConfigurationValue(const std::string& text, bool& value);
+bool parseConfigurationValue(const std::string& text, int& value);
+bool parseConfigurationValue(const std::string& text, std::string& value);
 
 /**
  * Base class for configuration options.
@@ -31,9 +37,9 @@ public:
     const std::string& getPath() const;
 
     /**
-     * Initialize the configuration option from the parsed property tree.
+     * Initialize the configuration option from the text of its value in the INI file.
      */
-    //virtual void initializeValue(const boost::property_tree::ptree& propertyTree)=0;
+    virtual void initializeValue(const std::string& text)=0;
 
 private:
     std::string path;
@@ -68,16 +74,43 @@ public:
     /**
      * Initialize the configuration option.
      */
-    /*void initializeValue(const boost::property_tree::ptree& propertyTree) override
+    void initializeValue(const std::string& text) override
     {
-        value = propertyTree.get<T>(getPath(), value);
-        std::cout << "Configuration option \"" << getPath() << "\" set to \"" << value << "\"" << std::endl;
-    }*/
+        if (parseConfigurationValue(text, value))
+        {
+            std::cout << "Configuration option \"" << getPath() << "\" set to \"" << value << "\"" << std::endl;
+        }
+        else
+        {
+            std::cout << "Invalid value \"" << text << "\" for configuration option \"" << getPath() << "\"" << std::endl;
+        }
+    }
 
 private:
     T value;
 };
 
+/**
+ * Frozen copy of the options used by the emulation hot paths, with derived
+ * values precomputed. Components keep their own copy so that per-frame code
+ * never goes through the Configuration accessors.
+ */
+struct RuntimeConfig
+{
+    bool audioEnabled;   /**< Whether the APU is stepped. */
+    int audioFrequency;  /**< Audio frequency, in Hz. */
+    int frameRate;       /**< Frames per second. */
+    int samplesPerFrame; /**< Audio samples generated per frame (derived). */
+
+    /**
+     * Recompute the derived values after changing any of the options.
+     */
+    void computeDerivedValues()
+    {
+        samplesPerFrame = (frameRate > 0) ? audioFrequency / frameRate : 0;
+    }
+};
+
 /**
  * Singleton class that reads the configuration file that provides global
  * program options from the user.
@@ -90,6 +123,11 @@ public:
      */
     static void initialize(const std::string& fileName);
 
+    /**
+     * Get the number of samples in the audio device buffer.
+     */
+    static int getAudioBufferSamples();
+
     /**
      * Get if audio is enabled or not.
      */
@@ -100,16 +138,86 @@ public:
      */
     static int getAudioFrequency();
 
+    /**
+     * Get the number of frames to emulate when rendering audio to a file.
+     */
+    static int getAudioRenderFrames();
+
+    /**
+     * Get the WAV file to render audio to without video. Empty to run the game normally.
+     */
+    static const std::string& getAudioRenderFileName();
+
+    /**
+     * Get the APU trace to replay instead of running the game when rendering audio to a file.
+     */
+    static const std::string& getAudioReplayFileName();
+
+    /**
+     * Get if audio is rendered in stereo or not.
+     */
+    static bool getAudioStereo();
+
+    /**
+     * Get the file to record APU register writes to. Empty to disable tracing.
+     */
+    static const std::string& getAudioTraceFileName();
+
+    /**
+     * Get the file the decoded areas are cached in. Empty to disable the cache.
+     */
+    static const std::string& getBatchAreaCacheFileName();
+
+    /**
+     * Get if the area parser benchmark runs instead of the game or not.
+     */
+    static bool getBatchAreaParser();
+
+    /**
+     * Get the number of frames each engine runs in the batch scaling benchmark.
+     */
+    static int getBatchFrames();
+
+    /**
+     * Get the number of engines in the batch scaling benchmark. 0 to run the game normally.
+     */
+    static int getBatchInstances();
+
     /**
      * Get the desired frame rate (per second).
      */
     static int getFrameRate();
 
+    /**
+     * Get the number of frames to skip rendering after each rendered frame.
+     */
+    static int getFrameSkip();
+
+    /**
+     * Get the key mapping for the player 1 controller.
+     */
+    static const std::string& getInputPlayer1();
+
+    /**
+     * Get the key mapping for the player 2 controller.
+     */
+    static const std::string& getInputPlayer2();
+
     /**
      * Get the filename for a custom palette to use for rendering.
      */
     static const std::string& getPaletteFileName();
 
+    /**
+     * Get the number of frames to run ahead of the displayed frame to hide input lag (0 to 2).
+     */
+    static int getRunAheadFrames();
+
+    /**
+     * Get a snapshot of the options used by the emulation hot paths.
+     */
+    static RuntimeConfig getRuntimeConfig();
+
     /**
      * Get the desired ROM file name.
      */
@@ -120,6 +228,11 @@ public:
      */
     static int getRenderScale();
 
+    /**
+     * Get whether frames are rendered on another core while the next frame is updated.
+     */
+    static bool getRenderThreadEnabled();
+
     /**
      * Get whether scanlines are enabled or not.
      */
@@ -131,12 +244,27 @@ public:
     static bool getVsyncEnabled();
 
 private:
+    static BasicConfigurationOption<int> audioBufferSamples;
     static BasicConfigurationOption<bool> audioEnabled;
     static BasicConfigurationOption<int> audioFrequency;
+    static BasicConfigurationOption<int> audioRenderFrames;
+    static BasicConfigurationOption<std::string> audioRenderFileName;
+    static BasicConfigurationOption<std::string> audioReplayFileName;
+    static BasicConfigurationOption<bool> audioStereo;
+    static BasicConfigurationOption<std::string> audioTraceFileName;
+    static BasicConfigurationOption<std::string> batchAreaCacheFileName;
+    static BasicConfigurationOption<bool> batchAreaParser;
+    static BasicConfigurationOption<int> batchFrames;
+    static BasicConfigurationOption<int> batchInstances;
     static BasicConfigurationOption<int> frameRate;
+    static BasicConfigurationOption<int> frameSkip;
+    static BasicConfigurationOption<std::string> inputPlayer1;
+    static BasicConfigurationOption<std::string> inputPlayer2;
     static BasicConfigurationOption<std::string> paletteFileName;
     static BasicConfigurationOption<int> renderScale;
+    static BasicConfigurationOption<bool> renderThreadEnabled;
     static BasicConfigurationOption<std::string> romFileName;
+    static BasicConfigurationOption<int> runAheadFrames;
     static BasicConfigurationOption<bool> scanlinesEnabled;
     static BasicConfigurationOption<bool> vsyncEnabled;
 
@@ -1,11 +1,16 @@
 #include <cmath>
 #include <cstring>
 
+#ifdef __3DS__
 #include <SDL/SDL.h>
-
-#include "../Configuration.hpp"
+#else
+// The host build has no audio device, so samples are never read from another thread
+static inline void SDL_LockAudio() {}
+static inline void SDL_UnlockAudio() {}
+#endif
 
 #include "APU.hpp"
+#include "APUTrace.hpp"
 
 #include "../tonccpy.h"
 
@@ -33,667 +38,1005 @@ static const uint16_t noiseTable[] = {
 };
 
 /**
- * Pulse waveform generator.
+ * Advance a channel timer that counts down to zero and then reloads from its period.
+ *
+ * @param timerValue the timer to advance.
+ * @param timerPeriod the value the timer reloads from.
+ * @param steps the number of timer steps.
+ * @return the number of times the timer reloaded.
  */
-class Pulse
-{
-    friend class APU;
-public:
-    explicit Pulse(uint8_t channel)
-    {
-        enabled = false;
-        this->channel = channel;
-        lengthEnabled = false;
-        lengthValue = 0;
-        timerPeriod = 0;
-        timerValue = 0;
-        dutyMode = 0;
-        dutyValue = 0;
-        sweepReload = false;
-        sweepEnabled = false;
-        sweepNegate = false;
-        sweepShift = 0;
-        sweepPeriod = 0;
-        sweepValue = 0;
-        envelopeEnabled = false;
-        envelopeLoop = false;
-        envelopeStart = false;
-        envelopePeriod = 0;
-        envelopeValue = 0;
-        envelopeVolume = 0;
-        constantVolume = 0;
+static int skipTimerSteps(uint16_t& timerValue, uint16_t timerPeriod, int steps)
+{
+    if (steps <= timerValue)
+    {
+        timerValue -= steps;
+        return 0;
     }
 
-    void writeControl(uint8_t value)
+    // Count down to zero and reload once, then complete as many full periods as fit
+    //
+    steps -= timerValue + 1;
+    int period = timerPeriod + 1;
+    timerValue = timerPeriod - (steps % period);
+
+    return 1 + steps / period;
+}
+
+//---------------------------------------------------------------------
+// Pulse
+//---------------------------------------------------------------------
+
+Pulse::Pulse(uint8_t channel)
+{
+    enabled = false;
+    this->channel = channel;
+    lengthEnabled = false;
+    lengthValue = 0;
+    timerPeriod = 0;
+    timerValue = 0;
+    dutyMode = 0;
+    dutyValue = 0;
+    sweepReload = false;
+    sweepEnabled = false;
+    sweepNegate = false;
+    sweepShift = 0;
+    sweepPeriod = 0;
+    sweepValue = 0;
+    envelopeEnabled = false;
+    envelopeLoop = false;
+    envelopeStart = false;
+    envelopePeriod = 0;
+    envelopeValue = 0;
+    envelopeVolume = 0;
+    constantVolume = 0;
+}
+
+void Pulse::writeControl(uint8_t value)
+{
+    dutyMode = (value >> 6) & 3;
+    lengthEnabled = ((value >> 5) & 1) == 0;
+    envelopeLoop = ((value >> 5) & 1) == 1;
+    envelopeEnabled = ((value >> 4) & 1) == 0;
+    envelopePeriod = value & 15;
+    constantVolume = value & 15;
+    envelopeStart = true;
+}
+
+void Pulse::writeSweep(uint8_t value)
+{
+    sweepEnabled = ((value >> 7) & 1) == 1;
+    sweepPeriod = ((value >> 4) & 7) + 1;
+    sweepNegate = ((value >> 3) & 1) == 1;
+    sweepShift = value & 7;
+    sweepReload = true;
+}
+
+void Pulse::writeTimerLow(uint8_t value)
+{
+    timerPeriod = (timerPeriod & 0xff00) | (uint16_t)value;
+}
+
+void Pulse::writeTimerHigh(uint8_t value)
+{
+    lengthValue = lengthTable[value >> 3];
+    timerPeriod = (timerPeriod & 0xff) | ((uint16_t)(value & 7) << 8);
+    envelopeStart = true;
+    dutyValue = 0;
+}
+
+void Pulse::stepTimer()
+{
+    if (timerValue == 0)
     {
-        dutyMode = (value >> 6) & 3;
-        lengthEnabled = ((value >> 5) & 1) == 0;
-        envelopeLoop = ((value >> 5) & 1) == 1;
-        envelopeEnabled = ((value >> 4) & 1) == 0;
-        envelopePeriod = value & 15;
-        constantVolume = value & 15;
-        envelopeStart = true;
+        timerValue = timerPeriod;
+        dutyValue = (dutyValue + 1) % 8;
     }
-
-    void writeSweep(uint8_t value)
+    else
     {
-        sweepEnabled = ((value >> 7) & 1) == 1;
-        sweepPeriod = ((value >> 4) & 7) + 1;
-        sweepNegate = ((value >> 3) & 1) == 1;
-        sweepShift = value & 7;
-        sweepReload = true;
+        timerValue--;
     }
+}
 
-    void writeTimerLow(uint8_t value)
+void Pulse::skipTimer(int steps)
+{
+    int reloads = skipTimerSteps(timerValue, timerPeriod, steps);
+    dutyValue = (dutyValue + reloads) % 8;
+}
+
+bool Pulse::isAudible() const
+{
+    return enabled &&
+        lengthValue > 0 &&
+        timerPeriod >= 8 && timerPeriod <= 0x7ff &&
+        (envelopeEnabled ? envelopeVolume : constantVolume) > 0;
+}
+
+void Pulse::stepEnvelope()
+{
+    if (envelopeStart)
     {
-        timerPeriod = (timerPeriod & 0xff00) | (uint16_t)value;
+        envelopeVolume = 15;
+        envelopeValue = envelopePeriod;
+        envelopeStart = false;
     }
-
-    void writeTimerHigh(uint8_t value)
+    else if (envelopeValue > 0)
     {
-        lengthValue = lengthTable[value >> 3];
-        timerPeriod = (timerPeriod & 0xff) | ((uint16_t)(value & 7) << 8);
-        envelopeStart = true;
-        dutyValue = 0;
+        envelopeValue--;
     }
-
-    void stepTimer()
+    else
     {
-        if (timerValue == 0)
+        if (envelopeVolume > 0)
         {
-            timerValue = timerPeriod;
-            dutyValue = (dutyValue + 1) % 8;
+            envelopeVolume--;
         }
-        else
+        else if (envelopeLoop)
         {
-            timerValue--;
+            envelopeVolume = 15;
         }
+        envelopeValue = envelopePeriod;
     }
+}
 
-    void stepEnvelope()
+void Pulse::stepSweep()
+{
+    if (sweepReload)
     {
-        if (envelopeStart)
-        {
-            envelopeVolume = 15;
-            envelopeValue = envelopePeriod;
-            envelopeStart = false;
-        }
-        else if (envelopeValue > 0)
+        if (sweepEnabled && sweepValue == 0)
         {
-            envelopeValue--;
+            sweep();
         }
-        else
+        sweepValue = sweepPeriod;
+        sweepReload = false;
+    }
+    else if (sweepValue > 0)
+    {
+        sweepValue--;
+    }
+    else
+    {
+        if (sweepEnabled)
         {
-            if (envelopeVolume > 0)
-            {
-                envelopeVolume--;
-            }
-            else if (envelopeLoop)
-            {
-                envelopeVolume = 15;
-            }
-            envelopeValue = envelopePeriod;
+            sweep();
         }
+        sweepValue = sweepPeriod;
     }
+}
 
-    void stepSweep()
+void Pulse::stepLength()
+{
+    if (lengthEnabled && lengthValue > 0)
     {
-        if (sweepReload)
-        {
-            if (sweepEnabled && sweepValue == 0)
-            {
-                sweep();
-            }
-            sweepValue = sweepPeriod;
-            sweepReload = false;
-        }
-        else if (sweepValue > 0)
-        {
-            sweepValue--;
-        }
-        else
-        {
-            if (sweepEnabled)
-            {
-                sweep();
-            }
-            sweepValue = sweepPeriod;
-        }
+        lengthValue--;
     }
+}
 
-    void stepLength()
+void Pulse::sweep()
+{
+    uint16_t delta = timerPeriod >> sweepShift;
+    if (sweepNegate)
     {
-        if (lengthEnabled && lengthValue > 0)
+        timerPeriod -= delta;
+        if (channel == 1)
         {
-            lengthValue--;
+            timerPeriod--;
         }
     }
+    else
+    {
+        timerPeriod += delta;
+    }
+}
 
-    void sweep()
+uint8_t Pulse::output()
+{
+    if (!enabled)
     {
-        uint16_t delta = timerPeriod >> sweepShift;
-        if (sweepNegate)
-        {
-            timerPeriod -= delta;
-            if (channel == 1)
-            {
-                timerPeriod--;
-            }
-        }
-        else
-        {
-            timerPeriod += delta;
-        }
+        return 0;
+    }
+    if (lengthValue == 0)
+    {
+        return 0;
+    }
+    if (dutyTable[dutyMode][dutyValue] == 0)
+    {
+        return 0;
     }
+    if (timerPeriod < 8 || timerPeriod > 0x7ff)
+    {
+        return 0;
+    }
+    if (envelopeEnabled)
+    {
+        return envelopeVolume;
+    }
+    else
+    {
+        return constantVolume;
+    }
+}
+
+//---------------------------------------------------------------------
+// Triangle
+//---------------------------------------------------------------------
+
+Triangle::Triangle()
+{
+    enabled = false;
+    lengthEnabled = false;
+    lengthValue = 0;
+    timerPeriod = 0;
+    timerValue = 0;
+    dutyValue = 0;
+    counterPeriod = 0;
+    counterValue = 0;
+    counterReload = false;
+}
 
-    uint8_t output()
+void Triangle::writeControl(uint8_t value)
+{
+    lengthEnabled = ((value >> 7) & 1) == 0;
+    counterPeriod = value & 0x7f;
+}
+
+void Triangle::writeTimerLow(uint8_t value)
+{
+    timerPeriod = (timerPeriod & 0xff00) | (uint16_t)value;
+}
+
+void Triangle::writeTimerHigh(uint8_t value)
+{
+    lengthValue = lengthTable[value >> 3];
+    timerPeriod = (timerPeriod & 0x00ff) | ((uint16_t)(value & 7) << 8);
+    timerValue = timerPeriod;
+    counterReload = true;
+}
+
+void Triangle::stepTimer()
+{
+    if (timerValue == 0)
     {
-        if (!enabled)
-        {
-            return 0;
-        }
-        if (lengthValue == 0)
-        {
-            return 0;
-        }
-        if (dutyTable[dutyMode][dutyValue] == 0)
-        {
-            return 0;
-        }
-        if (timerPeriod < 8 || timerPeriod > 0x7ff)
-        {
-            return 0;
-        }
-        if (envelopeEnabled)
-        {
-            return envelopeVolume;
-        }
-        else
+        timerValue = timerPeriod;
+        if (lengthValue > 0 && counterValue > 0)
         {
-            return constantVolume;
+            dutyValue = (dutyValue + 1) % 32;
         }
     }
+    else
+    {
+        timerValue--;
+    }
+}
 
-private:
-    bool enabled;
-    uint8_t channel;
-    bool lengthEnabled;
-    uint8_t lengthValue;
-    uint16_t timerPeriod;
-    uint16_t timerValue;
-    uint8_t dutyMode;
-    uint8_t dutyValue;
-    bool sweepReload;
-    bool sweepEnabled;
-    bool sweepNegate;
-    uint8_t sweepShift;
-    uint8_t sweepPeriod;
-    uint8_t sweepValue;
-    bool envelopeEnabled;
-    bool envelopeLoop;
-    bool envelopeStart;
-    uint8_t envelopePeriod;
-    uint8_t envelopeValue;
-    uint8_t envelopeVolume;
-    uint8_t constantVolume;
-};
-
-/**
- * Triangle waveform generator.
- */
-class Triangle
-{
-    friend class APU;
-public:
-    Triangle()
-    {
-        enabled = false;
-        lengthEnabled = false;
-        lengthValue = 0;
-        timerPeriod = 0;
-        dutyValue = 0;
-        counterPeriod = 0;
-        counterValue = 0;
-        counterReload = false;
+void Triangle::skipTimer(int steps)
+{
+    int reloads = skipTimerSteps(timerValue, timerPeriod, steps);
+    if (lengthValue > 0 && counterValue > 0)
+    {
+        dutyValue = (dutyValue + reloads) % 32;
     }
+}
+
+bool Triangle::isAudible() const
+{
+    return enabled && lengthValue > 0 && counterValue > 0;
+}
 
-    void writeControl(uint8_t value)
+void Triangle::stepLength()
+{
+    if (lengthEnabled && lengthValue > 0)
     {
-        lengthEnabled = ((value >> 7) & 1) == 0;
-        counterPeriod = value & 0x7f;
+        lengthValue--;
     }
+}
 
-    void writeTimerLow(uint8_t value)
+void Triangle::stepCounter()
+{
+    if (counterReload)
+    {
+        counterValue = counterPeriod;
+    }
+    else if (counterValue > 0)
+    {
+        counterValue--;
+    }
+    if (lengthEnabled)
     {
-        timerPeriod = (timerPeriod & 0xff00) | (uint16_t)value;
+        counterReload = false;
     }
+}
 
-    void writeTimerHigh(uint8_t value)
+uint8_t Triangle::output()
+{
+    if (!enabled)
     {
-        lengthValue = lengthTable[value >> 3];
-        timerPeriod = (timerPeriod & 0x00ff) | ((uint16_t)(value & 7) << 8);
-        timerValue = timerPeriod;
-        counterReload = true;
+        return 0;
+    }
+    if (lengthValue == 0)
+    {
+        return 0;
     }
+    if (counterValue == 0)
+    {
+        return 0;
+    }
+    return triangleTable[dutyValue];
+}
+
+//---------------------------------------------------------------------
+// Noise
+//---------------------------------------------------------------------
+
+Noise::Noise()
+{
+    enabled = false;
+    mode = false;
+    shiftRegister = 1;
+    lengthEnabled = false;
+    lengthValue = 0;
+    timerPeriod = 0;
+    timerValue = 0;
+    envelopeEnabled = false;
+    envelopeLoop = false;
+    envelopeStart = false;
+    envelopePeriod = 0;
+    envelopeValue = 0;
+    envelopeVolume = 0;
+    constantVolume = 0;
+}
+
+void Noise::writeControl(uint8_t value)
+{
+    lengthEnabled = ((value >> 5) & 1) == 0;
+    envelopeLoop = ((value >> 5) & 1) == 1;
+    envelopeEnabled = ((value >> 4) & 1) == 0;
+    envelopePeriod = value & 15;
+    constantVolume = value & 15;
+    envelopeStart = true;
+}
+
+void Noise::writePeriod(uint8_t value)
+{
+    mode = (value & 0x80) == 0x80;
+    timerPeriod = noiseTable[value & 0x0f];
+}
 
-    void stepTimer()
+void Noise::writeLength(uint8_t value)
+{
+    lengthValue = lengthTable[value >> 3];
+    envelopeStart = true;
+}
+
+void Noise::stepTimer()
+{
+    if (timerValue == 0)
     {
-        if (timerValue == 0)
+        timerValue = timerPeriod;
+        uint8_t shift;
+        if (mode)
         {
-            timerValue = timerPeriod;
-            if (lengthValue > 0 && counterValue > 0)
-            {
-                dutyValue = (dutyValue + 1) % 32;
-            }
+            shift = 6;
         }
         else
         {
-            timerValue--;
+            shift = 1;
         }
+        uint16_t b1 = shiftRegister & 1;
+        uint16_t b2 = (shiftRegister >> shift) & 1;
+        shiftRegister >>= 1;
+        shiftRegister |= (b1 ^ b2) << 14;
     }
-
-    void stepLength()
+    else
     {
-        if (lengthEnabled && lengthValue > 0)
-        {
-            lengthValue--;
-        }
+        timerValue--;
     }
+}
 
-    void stepCounter()
+void Noise::skipTimer(int steps)
+{
+    int reloads = skipTimerSteps(timerValue, timerPeriod, steps);
+    uint8_t shift = mode ? 6 : 1;
+    for (int i = 0; i < reloads; i++)
     {
-        if (counterReload)
-        {
-            counterValue = counterPeriod;
-        }
-        else if (counterValue > 0)
-        {
-            counterValue--;
-        }
-        if (lengthEnabled)
-        {
-            counterReload = false;
-        }
+        uint16_t b1 = shiftRegister & 1;
+        uint16_t b2 = (shiftRegister >> shift) & 1;
+        shiftRegister >>= 1;
+        shiftRegister |= (b1 ^ b2) << 14;
     }
+}
+
+bool Noise::isAudible() const
+{
+    return enabled &&
+        lengthValue > 0 &&
+        (envelopeEnabled ? envelopeVolume : constantVolume) > 0;
+}
 
-    uint8_t output()
+void Noise::stepEnvelope()
+{
+    if (envelopeStart)
     {
-        if (!enabled)
-        {
-            return 0;
-        }
-        if (lengthValue == 0)
+        envelopeVolume = 15;
+        envelopeValue = envelopePeriod;
+        envelopeStart = false;
+    }
+    else if (envelopeValue > 0)
+    {
+        envelopeValue--;
+    }
+    else
+    {
+        if (envelopeVolume > 0)
         {
-            return 0;
+            envelopeVolume--;
         }
-        if (counterValue == 0)
+        else if (envelopeLoop)
         {
-            return 0;
+            envelopeVolume = 15;
         }
-        return triangleTable[dutyValue];
-    }
-
-private:
-    bool enabled;
-    bool lengthEnabled;
-    uint8_t lengthValue;
-    uint16_t timerPeriod;
-    uint16_t timerValue;
-    uint8_t dutyValue;
-    uint8_t counterPeriod;
-    uint8_t counterValue;
-    bool counterReload;
-};
+        envelopeValue = envelopePeriod;
+    }
+}
 
-class Noise
-{
-    friend class APU;
-public:
-    Noise()
-    {
-        enabled = false;
-        mode = false;
-        shiftRegister = 1;
-        lengthEnabled = false;
-        lengthValue = 0;
-        timerPeriod = 0;
-        timerValue = 0;
-        envelopeEnabled = false;
-        envelopeLoop = false;
-        envelopeStart = false;
-        envelopePeriod = 0;
-        envelopeValue = 0;
-        envelopeVolume = 0;
-        constantVolume = 0;
+void Noise::stepLength()
+{
+    if (lengthEnabled && lengthValue > 0)
+    {
+        lengthValue--;
     }
+}
 
-    void writeControl(uint8_t value)
+uint8_t Noise::output()
+{
+    if (!enabled)
+    {
+        return 0;
+    }
+    if (lengthValue == 0)
+    {
+        return 0;
+    }
+    if ((shiftRegister & 1) == 1)
+    {
+        return 0;
+    }
+    if (envelopeEnabled)
+    {
+        return envelopeVolume;
+    }
+    else
     {
-        lengthEnabled = ((value >> 5) & 1) == 0;
-        envelopeLoop = ((value >> 5) & 1) == 1;
-        envelopeEnabled = ((value >> 4) & 1) == 0;
-        envelopePeriod = value & 15;
-        constantVolume = value & 15;
-        envelopeStart = true;
+        return constantVolume;
     }
+}
+
+/**
+ * APU cycles (half the CPU clock) at which each frame sequencer step happens,
+ * counted from the start of the sequence.
+ */
+static const uint16_t fourStepCycles[] = {
+    3729, 7457, 11186, 14915
+};
+static const uint16_t fiveStepCycles[] = {
+    3729, 7457, 11186, 14915, 18641
+};
+
+#define SEQUENCER_QUARTER 1 // Clock envelopes and the triangle's linear counter
+#define SEQUENCER_HALF    2 // Clock length counters and sweep units
 
-    void writePeriod(uint8_t value)
+/**
+ * Units clocked by each frame sequencer step.
+ */
+static const uint8_t fourStepActions[] = {
+    SEQUENCER_QUARTER,
+    SEQUENCER_QUARTER | SEQUENCER_HALF,
+    SEQUENCER_QUARTER,
+    SEQUENCER_QUARTER | SEQUENCER_HALF
+};
+static const uint8_t fiveStepActions[] = {
+    SEQUENCER_QUARTER,
+    SEQUENCER_QUARTER | SEQUENCER_HALF,
+    SEQUENCER_QUARTER,
+    0,
+    SEQUENCER_QUARTER | SEQUENCER_HALF
+};
+
+/**
+ * Relative level of each channel, used by the mixer (AudioChannel bit order).
+ */
+static const double channelGain[] = {
+    0.00752, 0.00752, 0.00851, 0.00494
+};
+
+/**
+ * Left/right weights of each channel for stereo output. Each pair sums to 2,
+ * so centered channels are as loud as in the mono mix.
+ */
+static const double stereoPan[][2] = {
+    {1.5, 0.5}, // Pulse 1
+    {0.5, 1.5}, // Pulse 2
+    {1.0, 1.0}, // Triangle
+    {1.0, 1.0}  // Noise
+};
+
+APU::APU(const RuntimeConfig& config) :
+    pulse1(1),
+    pulse2(2)
+{
+    audioBuffer = nullptr;
+    audioBufferLength = 0;
+    audioBufferCapacity = 0;
+    outputMode = AUDIO_OUTPUT_MONO;
+    reconfigure(config);
+    sequencerMode = false;
+    sequencerCycle = 0;
+    sequencerStep = 0;
+    frameCycles = APU_CYCLES_PER_FRAME;
+    frameCount = 0;
+    channelMask = AUDIO_CHANNEL_ALL;
+    traceRecorder = nullptr;
+    resetStatistics();
+}
+
+APU::~APU()
+{
+    delete [] audioBuffer;
+}
+
+void APU::allocateAudioBuffer()
+{
+    delete [] audioBuffer;
+    audioBufferCapacity = AUDIO_BUFFER_LENGTH * getChannelCount();
+    audioBuffer = new uint8_t[audioBufferCapacity];
+    audioBufferLength = 0;
+}
+
+int APU::getChannelCount() const
+{
+    switch (outputMode)
     {
-        mode = (value & 0x80) == 0x80;
-        timerPeriod = noiseTable[value & 0x0f];
+    case AUDIO_OUTPUT_STEREO:
+        return 2;
+    case AUDIO_OUTPUT_CHANNELS:
+        return AUDIO_MAX_CHANNELS;
+    default:
+        return 1;
     }
+}
+
+uint8_t APU::getChannelMask() const
+{
+    return channelMask;
+}
 
-    void writeLength(uint8_t value)
+const APUStatistics& APU::getStatistics() const
+{
+    return statistics;
+}
+
+int APU::output(uint8_t* buffer, int len)
+{
+    len = (len > audioBufferLength) ? audioBufferLength : len;
+    tonccpya(buffer, audioBuffer, len);
+    audioBufferLength -= len;
+    tonccpya(audioBuffer, audioBuffer + len, audioBufferLength);
+
+    return len;
+}
+
+int APU::outputChannels(uint8_t* buffers[AUDIO_MAX_CHANNELS], int samples)
+{
+    if (outputMode != AUDIO_OUTPUT_CHANNELS)
     {
-        lengthValue = lengthTable[value >> 3];
-        envelopeStart = true;
+        return 0;
     }
 
-    void stepTimer()
+    SDL_LockAudio();
+
+    int available = audioBufferLength / AUDIO_MAX_CHANNELS;
+    samples = (samples > available) ? available : samples;
+    for (int i = 0; i < samples; i++)
     {
-        if (timerValue == 0)
+        for (int channel = 0; channel < AUDIO_MAX_CHANNELS; channel++)
         {
-            timerValue = timerPeriod;
-            uint8_t shift;
-            if (mode)
-            {
-                shift = 6;
-            }
-            else
-            {
-                shift = 1;
-            }
-            uint16_t b1 = shiftRegister & 1;
-            uint16_t b2 = (shiftRegister >> shift) & 1;
-            shiftRegister >>= 1;
-            shiftRegister |= (b1 ^ b2) << 14;
-        }
-        else
-        {
-            timerValue--;
+            buffers[channel][i] = audioBuffer[i * AUDIO_MAX_CHANNELS + channel];
         }
     }
 
-    void stepEnvelope()
+    int consumed = samples * AUDIO_MAX_CHANNELS;
+    audioBufferLength -= consumed;
+    memmove(audioBuffer, audioBuffer + consumed, audioBufferLength);
+
+    SDL_UnlockAudio();
+
+    return samples;
+}
+
+void APU::reconfigure(const RuntimeConfig& config)
+{
+    this->config = config;
+    this->config.computeDerivedValues();
+
+    if (config.audioEnabled && audioBuffer == nullptr)
     {
-        if (envelopeStart)
-        {
-            envelopeVolume = 15;
-            envelopeValue = envelopePeriod;
-            envelopeStart = false;
-        }
-        else if (envelopeValue > 0)
-        {
-            envelopeValue--;
-        }
-        else
-        {
-            if (envelopeVolume > 0)
-            {
-                envelopeVolume--;
-            }
-            else if (envelopeLoop)
-            {
-                envelopeVolume = 15;
-            }
-            envelopeValue = envelopePeriod;
-        }
+        allocateAudioBuffer();
     }
+}
 
-    void stepLength()
+void APU::resetStatistics()
+{
+    memset(&statistics, 0, sizeof(statistics));
+}
+
+void APU::setChannelMask(uint8_t mask)
+{
+    channelMask = mask & AUDIO_CHANNEL_ALL;
+}
+
+void APU::setOutputMode(AudioOutputMode mode)
+{
+    SDL_LockAudio();
+    outputMode = mode;
+    audioBufferLength = 0;
+    if (audioBuffer != nullptr && audioBufferCapacity != AUDIO_BUFFER_LENGTH * getChannelCount())
     {
-        if (lengthEnabled && lengthValue > 0)
-        {
-            lengthValue--;
-        }
+        allocateAudioBuffer();
     }
+    SDL_UnlockAudio();
+}
 
-    uint8_t output()
+void APU::setTraceRecorder(APUTraceRecorder* recorder)
+{
+    traceRecorder = recorder;
+}
+
+void APU::writeSamples(uint8_t* buffer)
+{
+    uint8_t channelOut[AUDIO_MAX_CHANNELS] = {
+        (channelMask & AUDIO_CHANNEL_PULSE1) ? pulse1.output() : (uint8_t)0,
+        (channelMask & AUDIO_CHANNEL_PULSE2) ? pulse2.output() : (uint8_t)0,
+        (channelMask & AUDIO_CHANNEL_TRIANGLE) ? triangle.output() : (uint8_t)0,
+        (channelMask & AUDIO_CHANNEL_NOISE) ? noise.output() : (uint8_t)0
+    };
+
+    if (outputMode == AUDIO_OUTPUT_MONO)
     {
-        if (!enabled)
-        {
-            return 0;
-        }
-        if (lengthValue == 0)
-        {
-            return 0;
-        }
-        if ((shiftRegister & 1) == 1)
+        double level = 0.0;
+        for (int channel = 0; channel < AUDIO_MAX_CHANNELS; channel++)
         {
-            return 0;
+            level += channelGain[channel] * channelOut[channel];
         }
-        if (envelopeEnabled)
+        buffer[0] = static_cast<uint8_t>(floor(255.0 * level));
+    }
+    else if (outputMode == AUDIO_OUTPUT_STEREO)
+    {
+        double left = 0.0;
+        double right = 0.0;
+        for (int channel = 0; channel < AUDIO_MAX_CHANNELS; channel++)
         {
-            return envelopeVolume;
+            double level = channelGain[channel] * channelOut[channel];
+            left += stereoPan[channel][0] * level;
+            right += stereoPan[channel][1] * level;
         }
-        else
+        buffer[0] = static_cast<uint8_t>(floor(255.0 * left));
+        buffer[1] = static_cast<uint8_t>(floor(255.0 * right));
+    }
+    else
+    {
+        for (int channel = 0; channel < AUDIO_MAX_CHANNELS; channel++)
         {
-            return constantVolume;
+            buffer[channel] = static_cast<uint8_t>(floor(255.0 * channelGain[channel] * channelOut[channel]));
         }
     }
+}
 
-private:
-    bool enabled;
-    bool mode;
-    uint16_t shiftRegister;
-    bool lengthEnabled;
-    uint8_t lengthValue;
-    uint16_t timerPeriod;
-    uint16_t timerValue;
-    bool envelopeEnabled;
-    bool envelopeLoop;
-    bool envelopeStart;
-    uint8_t envelopePeriod;
-    uint8_t envelopeValue;
-    uint8_t envelopeVolume;
-    uint8_t constantVolume;
-};
-
-APU::APU()
+void APU::clockSequencer()
 {
-    frameValue = 0;
-    audioBufferLength = 0;
+    uint8_t action = sequencerMode ? fiveStepActions[sequencerStep] : fourStepActions[sequencerStep];
+    if (action & SEQUENCER_QUARTER)
+    {
+        stepEnvelope();
+    }
+    if (action & SEQUENCER_HALF)
+    {
+        stepSweep();
+        stepLength();
+    }
 
-    pulse1 = new Pulse(1);
-    pulse2 = new Pulse(2);
-    triangle = new Triangle;
-    noise = new Noise;
+    sequencerStep++;
+    if (sequencerStep == (sequencerMode ? 5 : 4))
+    {
+        sequencerStep = 0;
+        sequencerCycle = 0;
+    }
 }
 
-APU::~APU()
+void APU::restartSequencer(bool fiveStep)
 {
-    delete pulse1;
-    delete pulse2;
-    delete triangle;
-    delete noise;
+    // In 5-step mode, the quarter and half frame units are also clocked right away
+    //
+    sequencerMode = fiveStep;
+    sequencerCycle = 0;
+    sequencerStep = 0;
+    if (sequencerMode)
+    {
+        stepEnvelope();
+        stepSweep();
+        stepLength();
+    }
 }
 
-uint8_t APU::getOutput()
+void APU::synthesize(int startCycle, int endCycle, int& sampleIndex, int samplesToWrite, uint8_t& frameAudible)
 {
-    double pulseOut = 0.00752 * (pulse1->output() + pulse2->output());
-    double tndOut = 0.00851 * triangle->output() + 0.00494 * noise->output();
+    int channelCount = getChannelCount();
 
-    return static_cast<uint8_t>(floor(255.0 * (pulseOut + tndOut)));
-}
+    // Channels that are muted or cannot make a sound until the next frame sequencer
+    // step are not synthesized; their timers are fast-forwarded instead.
+    //
+    uint8_t audible = 0;
+    if ((channelMask & AUDIO_CHANNEL_PULSE1) && pulse1.isAudible())
+    {
+        audible |= AUDIO_CHANNEL_PULSE1;
+    }
+    if ((channelMask & AUDIO_CHANNEL_PULSE2) && pulse2.isAudible())
+    {
+        audible |= AUDIO_CHANNEL_PULSE2;
+    }
+    if ((channelMask & AUDIO_CHANNEL_TRIANGLE) && triangle.isAudible())
+    {
+        audible |= AUDIO_CHANNEL_TRIANGLE;
+    }
+    if ((channelMask & AUDIO_CHANNEL_NOISE) && noise.isAudible())
+    {
+        audible |= AUDIO_CHANNEL_NOISE;
+    }
+    frameAudible |= audible;
 
-void APU::output(uint8_t* buffer, int len)
-{
-    len = (len > audioBufferLength) ? audioBufferLength : len;
-    tonccpya(buffer, audioBuffer, len);
-    if (len > audioBufferLength)
+    SDL_LockAudio();
+
+    // Sample j is taken on the first cycle c where c / frameCycles > j / samplesToWrite
+    //
+    int j = sampleIndex;
+    uint8_t* buffer = audioBuffer + audioBufferLength;
+
+    if (audible == 0)
     {
-        tonccpya(buffer, audioBuffer, audioBufferLength);
-        audioBufferLength = 0;
+        // Every channel is silent, so is the output
+        //
+        int firstSample = j;
+        while (j < samplesToWrite && (endCycle - 1) * samplesToWrite > j * frameCycles)
+        {
+            j++;
+        }
+        memset(buffer, 0, (j - firstSample) * channelCount);
+        buffer += (j - firstSample) * channelCount;
     }
     else
     {
-        tonccpya(buffer, audioBuffer, len);
-        audioBufferLength -= len;
-        tonccpya(audioBuffer, audioBuffer + len, audioBufferLength);
+        bool stepPulse1 = (audible & AUDIO_CHANNEL_PULSE1) != 0;
+        bool stepPulse2 = (audible & AUDIO_CHANNEL_PULSE2) != 0;
+        bool stepTriangle = (audible & AUDIO_CHANNEL_TRIANGLE) != 0;
+        bool stepNoise = (audible & AUDIO_CHANNEL_NOISE) != 0;
+
+        for (int cycle = startCycle; cycle < endCycle; cycle++)
+        {
+            if (j < samplesToWrite && cycle * samplesToWrite > j * frameCycles)
+            {
+                writeSamples(buffer);
+                buffer += channelCount;
+                j++;
+            }
+
+            if (stepPulse1)
+            {
+                pulse1.stepTimer();
+            }
+            if (stepPulse2)
+            {
+                pulse2.stepTimer();
+            }
+            if (stepNoise)
+            {
+                noise.stepTimer();
+            }
+            if (stepTriangle)
+            {
+                triangle.stepTimer();
+                triangle.stepTimer();
+            }
+        }
+    }
+    audioBufferLength += (j - sampleIndex) * channelCount;
+    sampleIndex = j;
+
+    SDL_UnlockAudio();
+
+    int cycles = endCycle - startCycle;
+    if (!(audible & AUDIO_CHANNEL_PULSE1))
+    {
+        pulse1.skipTimer(cycles);
+    }
+    if (!(audible & AUDIO_CHANNEL_PULSE2))
+    {
+        pulse2.skipTimer(cycles);
+    }
+    if (!(audible & AUDIO_CHANNEL_NOISE))
+    {
+        noise.skipTimer(cycles);
+    }
+    if (!(audible & AUDIO_CHANNEL_TRIANGLE))
+    {
+        triangle.skipTimer(2 * cycles);
     }
 }
 
 void APU::stepFrame()
 {
-    // Step the frame counter 4 times per frame, for 240Hz
-    for (int i = 0; i < 4; i++)
+    // Frames alternate lengths so that the sequencer keeps in step with vblank
+    //
+    frameCount = (frameCount + 1) % APU_FRAMES_PER_EXTRA_CYCLE;
+    frameCycles = APU_CYCLES_PER_FRAME + ((frameCount == 0) ? 1 : 0);
+
+    // Example: we need 735 samples per frame for 44.1KHz sound sampling
+    //
+    int samplesToWrite = config.samplesPerFrame;
+
+    // Drop samples that no longer fit if the consumer has fallen behind
+    //
+    int samplesFree = (audioBuffer != nullptr) ? (audioBufferCapacity - audioBufferLength) / getChannelCount() : 0;
+    if (samplesToWrite > samplesFree)
+    {
+        samplesToWrite = samplesFree;
+    }
+
+    // Run the channels in batches between frame sequencer steps
+    //
+    uint8_t frameAudible = 0;
+    int sampleIndex = 0;
+    int cycle = 0;
+    while (cycle < frameCycles)
     {
-        frameValue = (frameValue + 1) % 5;
-        switch (frameValue)
+        const uint16_t* stepCycles = sequencerMode ? fiveStepCycles : fourStepCycles;
+        int endCycle = cycle + (stepCycles[sequencerStep] - sequencerCycle);
+        if (endCycle > frameCycles)
         {
-        case 1:
-        case 3:
-            stepEnvelope();
-            break;
-        case 0:
-        case 2:
-            stepEnvelope();
-            stepSweep();
-            stepLength();
-            break;
+            endCycle = frameCycles;
         }
 
-        // Calculate the number of samples needed per 1/4 frame
-        //
-        int frequency = Configuration::getAudioFrequency();
+        synthesize(cycle, endCycle, sampleIndex, samplesToWrite, frameAudible);
 
-        // Example: we need 735 samples per frame for 44.1KHz sound sampling
-        //
-        int samplesToWrite = frequency / (Configuration::getFrameRate() << 2);
-        if (i == 3)
+        sequencerCycle += endCycle - cycle;
+        cycle = endCycle;
+        if (sequencerCycle == stepCycles[sequencerStep])
         {
-            // Handle the remainder on the final tick of the frame counter
-            //
-            samplesToWrite = (frequency / Configuration::getFrameRate()) - 3 * (frequency / (Configuration::getFrameRate() << 2));
+            clockSequencer();
         }
-        
-        SDL_LockAudio();
+    }
 
-        // Step the timer ~3729 times per quarter frame for most channels
-        //
-        int j = 0;
-        for (int stepIndex = 0; stepIndex < 3729; stepIndex++)
+    // Update activity counters
+    //
+    statistics.frames++;
+    if (frameAudible == 0)
+    {
+        statistics.silentFrames++;
+    }
+    for (int channel = 0; channel < AUDIO_MAX_CHANNELS; channel++)
+    {
+        if (frameAudible & (1 << channel))
         {
-            if (j < samplesToWrite &&
-                (stepIndex / 3729.0) > (j / (double)samplesToWrite))
-            {
-                uint8_t sample = getOutput();
-                audioBuffer[audioBufferLength + j] = sample;
-                j++;
-            }
-
-            pulse1->stepTimer();
-            pulse2->stepTimer();
-            noise->stepTimer();
-            triangle->stepTimer();
-            triangle->stepTimer();
+            statistics.activeFrames[channel]++;
         }
-        audioBufferLength += samplesToWrite;
-        
-        SDL_UnlockAudio();
+    }
+
+    if (traceRecorder != nullptr)
+    {
+        traceRecorder->endFrame();
     }
 }
 
 void APU::stepEnvelope()
 {
-    pulse1->stepEnvelope();
-    pulse2->stepEnvelope();
-    triangle->stepCounter();
-    noise->stepEnvelope();
+    pulse1.stepEnvelope();
+    pulse2.stepEnvelope();
+    triangle.stepCounter();
+    noise.stepEnvelope();
 }
 
 void APU::stepSweep()
 {
-    pulse1->stepSweep();
-    pulse2->stepSweep();
+    pulse1.stepSweep();
+    pulse2.stepSweep();
 }
 
 void APU::stepLength()
 {
-    pulse1->stepLength();
-    pulse2->stepLength();
-    triangle->stepLength();
-    noise->stepLength();
+    pulse1.stepLength();
+    pulse2.stepLength();
+    triangle.stepLength();
+    noise.stepLength();
 }
 
 void APU::writeControl(uint8_t value)
 {
-    pulse1->enabled = (value & 1) == 1;
-    pulse2->enabled = (value & 2) == 2;
-    triangle->enabled = (value & 4) == 4;
-    noise->enabled = (value & 8) == 8;
-    if (!pulse1->enabled)
+    pulse1.enabled = (value & 1) == 1;
+    pulse2.enabled = (value & 2) == 2;
+    triangle.enabled = (value & 4) == 4;
+    noise.enabled = (value & 8) == 8;
+    if (!pulse1.enabled)
     {
-        pulse1->lengthValue = 0;
+        pulse1.lengthValue = 0;
     }
-    if (!pulse2->enabled)
+    if (!pulse2.enabled)
     {
-        pulse2->lengthValue = 0;
+        pulse2.lengthValue = 0;
     }
-    if (!triangle->enabled)
+    if (!triangle.enabled)
     {
-        triangle->lengthValue = 0;
+        triangle.lengthValue = 0;
     }
-    if (!noise->enabled)
+    if (!noise.enabled)
     {
-        noise->lengthValue = 0;
+        noise.lengthValue = 0;
     }
 }
 
 void APU::writeRegister(uint16_t address, uint8_t value)
 {
+    if (traceRecorder != nullptr)
+    {
+        traceRecorder->recordWrite(address, value);
+    }
+
     switch (address)
     {
     case 0x4000:
-        pulse1->writeControl(value);
+        pulse1.writeControl(value);
         break;
     case 0x4001:
-        pulse1->writeSweep(value);
+        pulse1.writeSweep(value);
         break;
     case 0x4002:
-        pulse1->writeTimerLow(value);
+        pulse1.writeTimerLow(value);
         break;
     case 0x4003:
-        pulse1->writeTimerHigh(value);
+        pulse1.writeTimerHigh(value);
         break;
     case 0x4004:
-        pulse2->writeControl(value);
+        pulse2.writeControl(value);
         break;
     case 0x4005:
-        pulse2->writeSweep(value);
+        pulse2.writeSweep(value);
         break;
     case 0x4006:
-        pulse2->writeTimerLow(value);
+        pulse2.writeTimerLow(value);
         break;
     case 0x4007:
-        pulse2->writeTimerHigh(value);
+        pulse2.writeTimerHigh(value);
         break;
     case 0x4008:
-        triangle->writeControl(value);
+        triangle.writeControl(value);
         break;
     case 0x400a:
-        triangle->writeTimerLow(value);
+        triangle.writeTimerLow(value);
         break;
     case 0x400b:
-        triangle->writeTimerHigh(value);
+        triangle.writeTimerHigh(value);
         break;
     case 0x400c:
-        noise->writeControl(value);
+        noise.writeControl(value);
         break;
     case 0x400d:
     case 0x400e:
-        noise->writePeriod(value);
+        noise.writePeriod(value);
         break;
     case 0x400f:
-        noise->writeLength(value);
+        noise.writeLength(value);
         break;
     case 0x4015:
         writeControl(value);
         break;
     case 0x4017:
-        stepEnvelope();
-        stepSweep();
-        stepLength();
+        restartSequencer((value & 0x80) != 0);
+        break;
     default:
         break;
     }
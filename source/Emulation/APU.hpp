@@ -3,19 +3,218 @@
 
 #include <cstdint>
 
-#define AUDIO_BUFFER_LENGTH 4096
+#include "../Configuration.hpp"
 
-class Pulse;
-class Triangle;
-class Noise;
+#define AUDIO_BUFFER_LENGTH 4096 // Samples buffered per output channel
+#define AUDIO_MAX_CHANNELS 4
+#define APU_CYCLES_PER_FRAME 14890 // Whole APU cycles (half the CPU clock) in an NTSC frame of 29780.5 CPU cycles
+#define APU_FRAMES_PER_EXTRA_CYCLE 4 // Every 4th frame is one APU cycle longer, for an average of 14890.25
+
+class APUTraceRecorder;
+
+/**
+ * Bits identifying the individual APU channels (same order as $4015).
+ */
+enum AudioChannel
+{
+    AUDIO_CHANNEL_PULSE1   = 1 << 0,
+    AUDIO_CHANNEL_PULSE2   = 1 << 1,
+    AUDIO_CHANNEL_TRIANGLE = 1 << 2,
+    AUDIO_CHANNEL_NOISE    = 1 << 3,
+    AUDIO_CHANNEL_ALL      = 0x0f
+};
+
+/**
+ * Layout of the samples produced by the APU.
+ */
+enum AudioOutputMode
+{
+    AUDIO_OUTPUT_MONO,    /**< One mixed sample per frame. */
+    AUDIO_OUTPUT_STEREO,  /**< Interleaved left/right samples with per-channel panning. */
+    AUDIO_OUTPUT_CHANNELS /**< Interleaved pulse1, pulse2, triangle and noise samples. */
+};
+
+/**
+ * Counters describing how often the APU channels are in use.
+ */
+struct APUStatistics
+{
+    uint32_t frames;                           /**< Frames stepped. */
+    uint32_t silentFrames;                     /**< Frames in which every channel was silent. */
+    uint32_t activeFrames[AUDIO_MAX_CHANNELS]; /**< Frames in which each channel could be heard (AudioChannel bit order). */
+};
+
+/**
+ * Pulse waveform generator.
+ */
+class Pulse
+{
+    friend class APU;
+public:
+    explicit Pulse(uint8_t channel);
+
+    void writeControl(uint8_t value);
+
+    void writeSweep(uint8_t value);
+
+    void writeTimerLow(uint8_t value);
+
+    void writeTimerHigh(uint8_t value);
+
+    void stepTimer();
+
+    /**
+     * Equivalent to calling stepTimer() the given number of times.
+     */
+    void skipTimer(int steps);
+
+    /**
+     * Check if the channel can produce any output until the next frame counter step.
+     */
+    bool isAudible() const;
+
+    void stepEnvelope();
+
+    void stepSweep();
+
+    void stepLength();
+
+    void sweep();
+
+    uint8_t output();
+
+private:
+    bool enabled;
+    uint8_t channel;
+    bool lengthEnabled;
+    uint8_t lengthValue;
+    uint16_t timerPeriod;
+    uint16_t timerValue;
+    uint8_t dutyMode;
+    uint8_t dutyValue;
+    bool sweepReload;
+    bool sweepEnabled;
+    bool sweepNegate;
+    uint8_t sweepShift;
+    uint8_t sweepPeriod;
+    uint8_t sweepValue;
+    bool envelopeEnabled;
+    bool envelopeLoop;
+    bool envelopeStart;
+    uint8_t envelopePeriod;
+    uint8_t envelopeValue;
+    uint8_t envelopeVolume;
+    uint8_t constantVolume;
+};
+
+/**
+ * Triangle waveform generator.
+ */
+class Triangle
+{
+    friend class APU;
+public:
+    Triangle();
+
+    void writeControl(uint8_t value);
+
+    void writeTimerLow(uint8_t value);
+
+    void writeTimerHigh(uint8_t value);
+
+    void stepTimer();
+
+    /**
+     * Equivalent to calling stepTimer() the given number of times.
+     */
+    void skipTimer(int steps);
+
+    /**
+     * Check if the channel can produce any output until the next frame counter step.
+     */
+    bool isAudible() const;
+
+    void stepLength();
+
+    void stepCounter();
+
+    uint8_t output();
+
+private:
+    bool enabled;
+    bool lengthEnabled;
+    uint8_t lengthValue;
+    uint16_t timerPeriod;
+    uint16_t timerValue;
+    uint8_t dutyValue;
+    uint8_t counterPeriod;
+    uint8_t counterValue;
+    bool counterReload;
+};
+
+/**
+ * Noise generator.
+ */
+class Noise
+{
+    friend class APU;
+public:
+    Noise();
+
+    void writeControl(uint8_t value);
+
+    void writePeriod(uint8_t value);
+
+    void writeLength(uint8_t value);
+
+    void stepTimer();
+
+    /**
+     * Equivalent to calling stepTimer() the given number of times.
+     */
+    void skipTimer(int steps);
+
+    /**
+     * Check if the channel can produce any output until the next frame counter step.
+     */
+    bool isAudible() const;
+
+    void stepEnvelope();
+
+    void stepLength();
+
+    uint8_t output();
+
+private:
+    bool enabled;
+    bool mode;
+    uint16_t shiftRegister;
+    bool lengthEnabled;
+    uint8_t lengthValue;
+    uint16_t timerPeriod;
+    uint16_t timerValue;
+    bool envelopeEnabled;
+    bool envelopeLoop;
+    bool envelopeStart;
+    uint8_t envelopePeriod;
+    uint8_t envelopeValue;
+    uint8_t envelopeVolume;
+    uint8_t constantVolume;
+};
 
 /**
  * Audio processing unit emulator.
+ *
+ * Register writes take effect in the order the game makes them, and all of
+ * them land between two stepFrame() calls: the game runs its sound engine
+ * once per frame, so the frame boundary is the position of every write.
+ * A $4017 write restarts the frame sequencer right away, which keeps it in
+ * step with the following writes of the same frame.
  */
 class APU
 {
 public:
-    APU();
+    explicit APU(const RuntimeConfig& config);
     ~APU();
 
     /**
@@ -23,24 +222,99 @@ public:
      */
     void stepFrame();
 
-    void output(uint8_t* buffer, int len);
+    /**
+     * Move buffered samples out of the APU.
+     *
+     * @return the number of bytes copied into the buffer.
+     */
+    int output(uint8_t* buffer, int len);
+
+    /**
+     * Copy buffered samples into one buffer per channel.
+     * Only valid in AUDIO_OUTPUT_CHANNELS mode.
+     *
+     * @param buffers one buffer per channel, in AudioChannel bit order.
+     * @param samples the maximum number of samples to copy into each buffer.
+     * @return the number of samples copied into each buffer.
+     */
+    int outputChannels(uint8_t* buffers[AUDIO_MAX_CHANNELS], int samples);
+
+    /**
+     * Get the number of interleaved bytes per sample frame for the current output mode.
+     */
+    int getChannelCount() const;
+
+    /**
+     * Get the mask of channels that are synthesized (AudioChannel bits).
+     */
+    uint8_t getChannelMask() const;
+
+    /**
+     * Get the channel activity counters.
+     */
+    const APUStatistics& getStatistics() const;
+
+    /**
+     * Apply changed runtime options. Takes effect from the next frame.
+     * The sample buffer is allocated the first time audio is enabled; until
+     * then the channels still run but no samples are produced.
+     */
+    void reconfigure(const RuntimeConfig& config);
+
+    /**
+     * Reset the channel activity counters.
+     */
+    void resetStatistics();
+
+    /**
+     * Set the mask of channels that are synthesized. Muted channels are not synthesized.
+     */
+    void setChannelMask(uint8_t mask);
+
+    /**
+     * Set the layout of the generated samples. Discards any buffered samples,
+     * and resizes the sample buffer if the number of output channels changes.
+     */
+    void setOutputMode(AudioOutputMode mode);
+
+    /**
+     * Attach a recorder that logs every register write, or nullptr to stop tracing.
+     */
+    void setTraceRecorder(APUTraceRecorder* recorder);
 
     void writeRegister(uint16_t address, uint8_t value);
 
 private:
-    uint8_t audioBuffer[AUDIO_BUFFER_LENGTH];
+    uint8_t* audioBuffer;    /**< Buffered samples, allocated only while audio is enabled. */
     int audioBufferLength;
+    int audioBufferCapacity; /**< Size of audioBuffer in bytes (AUDIO_BUFFER_LENGTH samples of the output mode). */
+
+    // Frame sequencer
+    bool sequencerMode;      /**< false for the 4-step sequence, true for the 5-step sequence. */
+    int sequencerCycle;      /**< APU cycles since the start of the sequence, carried across frames. */
+    int sequencerStep;       /**< Index of the next sequencer step. */
+    int frameCycles;         /**< APU cycles in the frame being stepped. */
+    int frameCount;          /**< Frames stepped, modulo APU_FRAMES_PER_EXTRA_CYCLE. */
+
+    RuntimeConfig config;
+    AudioOutputMode outputMode;
+    uint8_t channelMask; /**< Channels that are synthesized (AudioChannel bits). */
 
-    int frameValue; /**< The value of the frame counter. */
+    APUTraceRecorder* traceRecorder;
+    APUStatistics statistics;
 
-    Pulse* pulse1;
-    Pulse* pulse2;
-    Triangle* triangle;
-    Noise* noise;
+    Pulse pulse1;
+    Pulse pulse2;
+    Triangle triangle;
+    Noise noise;
 
-    uint8_t getOutput();
+    void allocateAudioBuffer();
+    void clockSequencer();
+    void restartSequencer(bool fiveStep);
+    void writeSamples(uint8_t* buffer);
     void stepEnvelope();
     void stepSweep();
+    void synthesize(int startCycle, int endCycle, int& sampleIndex, int samplesToWrite, uint8_t& frameAudible);
     void stepLength();
     void writeControl(uint8_t value);
 };
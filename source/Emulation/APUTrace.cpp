@@ -0,0 +1,198 @@
+#include "APU.hpp"
+
+#include "APUTrace.hpp"
+
+static const uint8_t traceMagic[] = { 'A', 'P', 'U', 'T' };
+
+//---------------------------------------------------------------------
+// APUTraceRecorder
+//---------------------------------------------------------------------
+
+APUTraceRecorder::APUTraceRecorder()
+{
+    file = nullptr;
+    frameDelta = 0;
+    writeIndex = 0;
+    writeCount = 0;
+}
+
+APUTraceRecorder::~APUTraceRecorder()
+{
+    close();
+}
+
+void APUTraceRecorder::close()
+{
+    if (file == nullptr)
+    {
+        return;
+    }
+
+    // Keep trailing frames without writes so the trace plays for the full length
+    //
+    while (frameDelta > 0)
+    {
+        uint8_t delta = (frameDelta > 0xff) ? 0xff : frameDelta;
+        writeRecord(delta, 0, APU_TRACE_NO_REGISTER, 0);
+        frameDelta -= delta;
+    }
+
+    fclose(file);
+    file = nullptr;
+}
+
+void APUTraceRecorder::endFrame()
+{
+    frameDelta++;
+    writeIndex = 0;
+}
+
+uint32_t APUTraceRecorder::getWriteCount() const
+{
+    return writeCount;
+}
+
+bool APUTraceRecorder::open(const std::string& fileName)
+{
+    close();
+
+    file = fopen(fileName.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    frameDelta = 0;
+    writeIndex = 0;
+    writeCount = 0;
+
+    uint8_t version = APU_TRACE_VERSION;
+    fwrite(traceMagic, 1, sizeof(traceMagic), file);
+    return fwrite(&version, 1, 1, file) == 1;
+}
+
+void APUTraceRecorder::recordWrite(uint16_t address, uint8_t value)
+{
+    if (file == nullptr)
+    {
+        return;
+    }
+
+    while (frameDelta > 0xff)
+    {
+        writeRecord(0xff, 0, APU_TRACE_NO_REGISTER, 0);
+        frameDelta -= 0xff;
+    }
+
+    writeRecord(frameDelta, (writeIndex > 0xff) ? 0xff : writeIndex, address - 0x4000, value);
+    frameDelta = 0;
+    writeIndex++;
+    writeCount++;
+}
+
+void APUTraceRecorder::writeRecord(uint8_t delta, uint8_t index, uint8_t reg, uint8_t value)
+{
+    uint8_t record[APU_TRACE_RECORD_LENGTH] = { delta, index, reg, value };
+    fwrite(record, 1, sizeof(record), file);
+}
+
+//---------------------------------------------------------------------
+// APUTracePlayer
+//---------------------------------------------------------------------
+
+APUTracePlayer::APUTracePlayer()
+{
+    position = 0;
+    frame = 0;
+    recordFrame = 0;
+    frameCount = 0;
+}
+
+uint32_t APUTracePlayer::getFrameCount() const
+{
+    return frameCount;
+}
+
+bool APUTracePlayer::isFinished() const
+{
+    return frame >= frameCount;
+}
+
+bool APUTracePlayer::load(const std::string& fileName)
+{
+    records.clear();
+    frameCount = 0;
+    rewind();
+
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    uint8_t header[APU_TRACE_HEADER_LENGTH];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) ||
+        header[0] != traceMagic[0] || header[1] != traceMagic[1] ||
+        header[2] != traceMagic[2] || header[3] != traceMagic[3] ||
+        header[4] != APU_TRACE_VERSION)
+    {
+        fclose(file);
+        return false;
+    }
+
+    uint8_t buffer[1024];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        records.insert(records.end(), buffer, buffer + length);
+    }
+    fclose(file);
+
+    // Drop a partially written final record
+    //
+    records.resize(records.size() - (records.size() % APU_TRACE_RECORD_LENGTH));
+
+    for (size_t i = 0; i < records.size(); i += APU_TRACE_RECORD_LENGTH)
+    {
+        frameCount += records[i];
+    }
+
+    return true;
+}
+
+void APUTracePlayer::rewind()
+{
+    position = 0;
+    frame = 0;
+    recordFrame = 0;
+}
+
+bool APUTracePlayer::stepFrame(APU& apu)
+{
+    if (isFinished())
+    {
+        return false;
+    }
+
+    while (position < records.size())
+    {
+        uint32_t nextFrame = recordFrame + records[position];
+        if (nextFrame > frame)
+        {
+            break;
+        }
+        recordFrame = nextFrame;
+
+        uint8_t reg = records[position + 2];
+        if (reg != APU_TRACE_NO_REGISTER)
+        {
+            apu.writeRegister(0x4000 + reg, records[position + 3]);
+        }
+        position += APU_TRACE_RECORD_LENGTH;
+    }
+
+    apu.stepFrame();
+    frame++;
+
+    return true;
+}
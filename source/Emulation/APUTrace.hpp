@@ -0,0 +1,115 @@
+#ifndef APUTRACE_HPP
+#define APUTRACE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class APU;
+
+/**
+ * APU register trace file format:
+ *
+ * The file starts with the 4-byte magic "APUT" followed by a version byte.
+ * Each register write is then stored as a 4-byte record:
+ *
+ *   [0] number of frames since the previous record (0-255)
+ *   [1] index of the write within its frame (saturates at 255)
+ *   [2] register offset from $4000 ($ff for a record that only advances frames)
+ *   [3] value written
+ *
+ * A frame ends each time APU::stepFrame() runs.
+ */
+#define APU_TRACE_VERSION 1
+#define APU_TRACE_HEADER_LENGTH 5
+#define APU_TRACE_RECORD_LENGTH 4
+#define APU_TRACE_NO_REGISTER 0xff
+
+/**
+ * Records APU register writes to a trace file as they happen.
+ */
+class APUTraceRecorder
+{
+public:
+    APUTraceRecorder();
+    ~APUTraceRecorder();
+
+    /**
+     * Flush and close the trace file.
+     */
+    void close();
+
+    /**
+     * Mark the end of a frame.
+     */
+    void endFrame();
+
+    /**
+     * Get the number of writes recorded so far.
+     */
+    uint32_t getWriteCount() const;
+
+    /**
+     * Create a trace file and start recording.
+     */
+    bool open(const std::string& fileName);
+
+    /**
+     * Record a single register write in the current frame.
+     */
+    void recordWrite(uint16_t address, uint8_t value);
+
+private:
+    FILE* file;
+    uint32_t frameDelta;   /**< Frames since the last record was written. */
+    uint32_t writeIndex;   /**< Index of the next write within the current frame. */
+    uint32_t writeCount;
+
+    void writeRecord(uint8_t delta, uint8_t index, uint8_t reg, uint8_t value);
+};
+
+/**
+ * Replays a recorded trace straight into an APU, without running the game.
+ */
+class APUTracePlayer
+{
+public:
+    APUTracePlayer();
+
+    /**
+     * Get the number of frames in the loaded trace.
+     */
+    uint32_t getFrameCount() const;
+
+    /**
+     * Check if all frames of the trace have been played.
+     */
+    bool isFinished() const;
+
+    /**
+     * Load a trace file into memory.
+     */
+    bool load(const std::string& fileName);
+
+    /**
+     * Rewind to the start of the trace.
+     */
+    void rewind();
+
+    /**
+     * Apply the register writes of the next frame to the APU, then step it by one frame.
+     *
+     * @return false if the trace has already finished.
+     */
+    bool stepFrame(APU& apu);
+
+private:
+    std::vector<uint8_t> records;
+    size_t position;       /**< Offset of the next unplayed record. */
+    uint32_t frame;        /**< Current frame number. */
+    uint32_t recordFrame;  /**< Frame number of the last played record. */
+    uint32_t frameCount;
+};
+
+#endif // APUTRACE_HPP
@@ -2,41 +2,47 @@
 
 Controller::Controller()
 {
-    for( auto& b : buttonStates )
-    {
-        b = false;
-    }
-    buttonIndex = 0;
+    buttons = 0;
+    shiftRegister = 0xffff;
     strobe = 1;
 }
 
-uint8_t Controller::readByte()
+uint8_t Controller::getButtons() const
 {
-    uint8_t value = 1;
+    return buttons;
+}
 
-    if( buttonIndex < 8 )
-    {
-        value = (buttonStates[buttonIndex] ? 0x41 : 0x40);
-    }
+uint8_t Controller::readByte()
+{
+    // While the strobe is high the register keeps reloading, so reads return button A.
+    // Once all 8 buttons have been shifted out, reads return 1.
+    //
+    uint16_t reload = -(uint16_t)(strobe & (1 << 0));
+    shiftRegister = (shiftRegister & ~reload) | ((0xff00 | buttons) & reload);
 
-    if( (strobe & (1 << 0)) == 0 )
-    {
-        buttonIndex++;
-    }
+    uint8_t value = 0x40 | (shiftRegister & 1);
+    shiftRegister = (shiftRegister >> 1) | 0x8000;
 
     return value;
 }
 
 void Controller::setButtonState( ControllerButton button, bool state )
 {
-    buttonStates[(int)button] = state;
+    buttons = (buttons & ~(1 << (int)button)) | ((state ? 1 : 0) << (int)button);
+}
+
+void Controller::setButtons( uint8_t buttons )
+{
+    this->buttons = buttons;
 }
 
 void Controller::writeByte( uint8_t value )
 {
+    // Latch the buttons when the strobe goes from high to low
+    //
     if( (value & (1 << 0)) == 0 && (strobe & (1 << 0)) == 1 )
     {
-        buttonIndex = 0;
+        shiftRegister = 0xff00 | buttons;
     }
     strobe = value;
 }
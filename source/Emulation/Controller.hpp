@@ -26,6 +26,11 @@ class Controller
 public:
     Controller();
 
+    /**
+     * Get the state of all buttons, one bit per ControllerButton.
+     */
+    uint8_t getButtons() const;
+
     /**
      * Read from the controller register.
      */
@@ -36,15 +41,20 @@ public:
      */
     void setButtonState( ControllerButton button, bool state );
 
+    /**
+     * Set the state of all buttons at once, one bit per ControllerButton.
+     */
+    void setButtons( uint8_t buttons );
+
     /**
      * Write a byte to the controller register.
      */
     void writeByte( uint8_t value );
 
 private:
-    bool    buttonStates[8];
-    uint8_t buttonIndex;
-    uint8_t strobe;
+    uint8_t  buttons;       /**< Current button state, one bit per ControllerButton. */
+    uint16_t shiftRegister; /**< Button state latched by the strobe, shifted out by reads. */
+    uint8_t  strobe;
 };
 
 #endif // CONTROLLER_HPP
@@ -3,53 +3,173 @@
 
 #include <cstdint>
 
-class SMBEngine;
+/**
+ * Force inlining of the operations used by nearly every decompiled instruction.
+ */
+#define MEMORY_ACCESS_INLINE [[gnu::always_inline]]
 
 /**
  * Wraps operations to memory values/registers so that status flags can be set for branch operations.
+ *
+ * Every operation is inline, so that an access to a fixed RAM address in the
+ * decompiled code compiles down to a load or store instead of a function call.
+ *
+ * @tparam CPU the class that holds the flags (SMBEngine). Only instantiated
+ * where that class is complete.
  */
+template <class CPU>
 class MemoryAccess
 {
 public:
     /**
      * Construct a MemoryAccess to a location.
      */
-    MemoryAccess(SMBEngine& engine, uint8_t* value);
+    MEMORY_ACCESS_INLINE constexpr MemoryAccess(CPU& cpu, uint8_t* value) :
+        cpu(cpu),
+        value(value),
+        constant(0)
+    {
+    }
 
     /**
      * Construct a MemoryAccess to a constant value.
      */
-    MemoryAccess(SMBEngine& engine, uint8_t constant);
-
-    MemoryAccess& operator = (uint8_t value);
-    MemoryAccess& operator = (const MemoryAccess& rhs);
-    MemoryAccess& operator += (uint8_t value);
-    MemoryAccess& operator -= (uint8_t value);
-    MemoryAccess& operator ++ ();
-    MemoryAccess& operator -- ();
-    MemoryAccess& operator ++ (int unused);
-    MemoryAccess& operator -- (int unused);
-    MemoryAccess& operator &= (uint8_t value);
-    MemoryAccess& operator |= (uint8_t value);
-    MemoryAccess& operator ^= (uint8_t value);
-    MemoryAccess& operator <<= (int shift);
-    MemoryAccess& operator >>= (int shift);
-    operator uint8_t();
+    MEMORY_ACCESS_INLINE constexpr MemoryAccess(CPU& cpu, uint8_t constant) :
+        cpu(cpu),
+        value(&this->constant), // Thanks to plgDavid
+        constant(constant)
+    {
+    }
+
+    /**
+     * Not copyable: a MemoryAccess to a constant points to its own copy of the value.
+     */
+    MemoryAccess(const MemoryAccess&) = delete;
+
+    MEMORY_ACCESS_INLINE MemoryAccess& operator = (uint8_t rhs)
+    {
+        *value = rhs;
+        setZN();
+        return *this;
+    }
+
+    MEMORY_ACCESS_INLINE MemoryAccess& operator = (const MemoryAccess& rhs)
+    {
+        return (*this) = *(rhs.value);
+    }
+
+    MEMORY_ACCESS_INLINE MemoryAccess& operator += (uint8_t rhs)
+    {
+        uint16_t temp = *value + rhs + (cpu.c ? 1 : 0);
+        *value = temp & 0xff;
+        setZN();
+        cpu.c = temp > 0xff;
+        return *this;
+    }
+
+    MEMORY_ACCESS_INLINE MemoryAccess& operator -= (uint8_t rhs)
+    {
+        uint16_t temp = *value - rhs - (cpu.c ? 0 : 1);
+        *value = temp & 0xff;
+        setZN();
+        cpu.c = temp < 0x100;
+        return *this;
+    }
+
+    MEMORY_ACCESS_INLINE MemoryAccess& operator ++ ()
+    {
+        (*value)++;
+        setZN();
+        return *this;
+    }
+
+    MEMORY_ACCESS_INLINE MemoryAccess& operator -- ()
+    {
+        (*value)--;
+        setZN();
+        return *this;
+    }
+
+    MEMORY_ACCESS_INLINE MemoryAccess& operator ++ (int) { return ++(*this); }
+    MEMORY_ACCESS_INLINE MemoryAccess& operator -- (int) { return --(*this); }
+
+    MEMORY_ACCESS_INLINE MemoryAccess& operator &= (uint8_t rhs)
+    {
+        *value &= rhs;
+        setZN();
+        return *this;
+    }
+
+    MEMORY_ACCESS_INLINE MemoryAccess& operator |= (uint8_t rhs)
+    {
+        *value |= rhs;
+        setZN();
+        return *this;
+    }
+
+    MEMORY_ACCESS_INLINE MemoryAccess& operator ^= (uint8_t rhs)
+    {
+        *value ^= rhs;
+        setZN();
+        return *this;
+    }
+
+    MEMORY_ACCESS_INLINE MemoryAccess& operator <<= (int shift)
+    {
+        for (int i = 0; i < shift; i++)
+        {
+            cpu.c = (*value & (1 << 7)) != 0;
+            *value = (*value << 1) & 0xfe;
+            setZN();
+        }
+        return *this;
+    }
+
+    MEMORY_ACCESS_INLINE MemoryAccess& operator >>= (int shift)
+    {
+        for (int i = 0; i < shift; i++)
+        {
+            cpu.c = (*value & (1 << 0)) != 0;
+            *value = (*value >> 1) & 0x7f;
+            setZN();
+        }
+        return *this;
+    }
+
+    MEMORY_ACCESS_INLINE constexpr operator uint8_t() const { return *value; }
 
     /**
      * Circular left bit rotation.
      */
-    void rol();
+    MEMORY_ACCESS_INLINE void rol()
+    {
+        bool bit7 = (*value & (1 << 7)) != 0;
+        *value = (*value << 1) | (cpu.c ? (1 << 0) : 0);
+        cpu.c = bit7;
+        setZN();
+    }
 
     /**
      * Circular right bit rotation.
      */
-    void ror();
+    MEMORY_ACCESS_INLINE void ror()
+    {
+        bool bit0 = (*value & (1 << 0)) != 0;
+        *value = (*value >> 1) | (cpu.c ? (1 << 7) : 0);
+        cpu.c = bit0;
+        setZN();
+    }
 
 private:
-    SMBEngine& engine;
+    CPU& cpu;
     uint8_t* value;
     uint8_t constant;
+
+    MEMORY_ACCESS_INLINE void setZN()
+    {
+        cpu.z = (*value == 0);
+        cpu.n = (*value & (1 << 7)) != 0;
+    }
 };
 
 #endif // MEMORYACCESS_HPP
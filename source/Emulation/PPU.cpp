@@ -1,13 +1,44 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
 #include "../SMB/SMBEngine.hpp"
 #include "../Util/Video.hpp"
 
 #include "PPU.hpp"
 
-static const uint8_t nametableMirrorLookup[][4] = {
-    {0, 0, 1, 1}, // Vertical
-    {0, 1, 0, 1}  // Horizontal
+/**
+ * Location of the attribute bits for each tile of a nametable.
+ */
+struct AttributeLookup
+{
+    uint16_t offset; /**< Offset of the attribute byte in the nametable. */
+    uint8_t shift;   /**< Shift of the 2 attribute bits in the byte. */
 };
 
+/**
+ * Attribute locations of the 960 tiles (32x30) of a nametable, computed once
+ * so rendering needs no row, column or shift arithmetic per tile. Covers the
+ * whole 1KB nametable so any 10 bit index is in range; the entries of the
+ * attribute bytes themselves (960-1023) are never used and stay zero.
+ */
+static const struct AttributeLookupTable
+{
+    AttributeLookup entries[1024] = {};
+
+    AttributeLookupTable()
+    {
+        for (int tile = 0; tile < 960; tile++)
+        {
+            // Each attribute byte covers 4x4 tiles, 2 bits for each 2x2 quarter
+            int row = tile >> 5;
+            int column = tile & 0x1f;
+            entries[tile].offset = 0x3c0 + ((row >> 2) << 3) + (column >> 2);
+            entries[tile].shift = ((row & 0x2) ? 4 : 0) + ((column & 0x2) ? 2 : 0);
+        }
+    }
+} attributeLookup;
+
 /**
  * Default hardcoded palette.
  */
@@ -83,38 +114,93 @@ static constexpr const uint32_t defaultPaletteRGB[64] = {
  */
 const uint32_t* paletteRGB = defaultPaletteRGB;
 
-PPU::PPU(SMBEngine& engine) :
+PPU::PPU(SMBEngine& engine, NametableMirroring mirroring) :
     engine(engine)
 {
-    currentAddress = 0;
-    writeToggle = false;
+    mirroringShift = (mirroring == MIRRORING_HORIZONTAL) ? 1 : 0;
+    reset();
 }
 
-uint8_t PPU::getAttributeTableValue(uint16_t nametableAddress)
+/**
+ * Print the first difference between two byte arrays of the PPU state.
+ *
+ * @return true if they match.
+ */
+static bool compareBytes(const uint8_t* actual, const uint8_t* expected, int length, const char* field,
+    const char* name, std::ostream& stream)
 {
-    nametableAddress = getNametableIndex(nametableAddress);
+    for (int i = 0; i < length; i++)
+    {
+        if (actual[i] != expected[i])
+        {
+            stream << name << " left PPU " << field << "[$" << std::hex << i << "] = $" << (int)actual[i]
+                << ", decompiled code left $" << (int)expected[i] << std::dec << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PPU::compareState(const PPU& expected, const char* name, std::ostream& stream) const
+{
+    unsigned int registers[] = { ppuCtrl, ppuMask, ppuScrollX, ppuScrollY, currentAddress, writeToggle };
+    unsigned int expectedRegisters[] = {
+        expected.ppuCtrl, expected.ppuMask, expected.ppuScrollX, expected.ppuScrollY,
+        expected.currentAddress, expected.writeToggle
+    };
+    const char* registerNames[] = { "PPUCTRL", "PPUMASK", "scroll X", "scroll Y", "VRAM address", "write toggle" };
+    for (int i = 0; i < 6; i++)
+    {
+        if (registers[i] != expectedRegisters[i])
+        {
+            stream << name << " left PPU " << registerNames[i] << " = $" << std::hex << registers[i]
+                << ", decompiled code left $" << expectedRegisters[i] << std::dec << "\n";
+            return false;
+        }
+    }
 
-    // Determine the 32x32 attribute table address
-    int row = ((nametableAddress & 0x3e0) >> 5) >> 2;
-    int col = (nametableAddress & 0x1f) >> 2;
+    return compareBytes(nametable, expected.nametable, sizeof(nametable), "nametable", name, stream) &&
+        compareBytes(palette, expected.palette, sizeof(palette), "palette", name, stream) &&
+        compareBytes(oam, expected.oam, sizeof(oam), "OAM", name, stream);
+}
 
-    // Determine the 16x16 metatile for the 8x8 tile addressed
-    int shift = ((nametableAddress & (1 << 6)) ? 4 : 0) + ((nametableAddress & (1 << 1)) ? 2 : 0);
+void PPU::copyState(const PPU& source)
+{
+    copyRenderState(source);
+    oamAddress = source.oamAddress;
+    ppuStatus = source.ppuStatus;
+    currentAddress = source.currentAddress;
+    writeToggle = source.writeToggle;
+    vramBuffer = source.vramBuffer;
+    statusReads = source.statusReads;
+}
 
-    // Determine the offset into the attribute table
-    int offset = (nametableAddress & 0xc00) + 0x400 - 64 + ((row << 3) + col);
+void PPU::copyRenderState(const PPU& source)
+{
+    ppuCtrl = source.ppuCtrl;
+    ppuMask = source.ppuMask;
+    ppuScrollX = source.ppuScrollX;
+    ppuScrollY = source.ppuScrollY;
+    mirroringShift = source.mirroringShift;
+    memcpy(palette, source.palette, sizeof(palette));
+    memcpy(nametable, source.nametable, sizeof(nametable));
+    memcpy(oam, source.oam, sizeof(oam));
+}
+
+uint8_t PPU::getAttributeTableValue(uint16_t nametableAddress)
+{
+    // Only valid for tiles, not for the attribute bytes themselves
+    uint16_t index = getNametableIndex(nametableAddress);
+    const AttributeLookup& lookup = attributeLookup.entries[index & 0x3ff];
 
-    // Determine the attribute table value
-    return (nametable[offset] & (0x3 << shift)) >> shift;
+    return (nametable[(index & 0x400) + lookup.offset] >> lookup.shift) & 0x3;
 }
 
 uint16_t PPU::getNametableIndex(uint16_t address)
 {
-    address = (address - 0x2000) % 0x1000;
-    int table = address / 0x400; //No mul to div here.
-    int offset = address % 0x400;
-    int mode = 1; // Mirroring mode for Super Mario Bros.
-    return (nametableMirrorLookup[mode][table] * 0x400 + offset) % 2048;
+    // Keep the offset in the nametable and the address bit that selects the
+    // physical nametable for the mirroring mode
+    return (address & 0x3ff) | (((address >> mirroringShift) & 0x400));
 }
 
 uint8_t PPU::readByte(uint16_t address)
@@ -167,13 +253,12 @@ uint8_t PPU::readDataRegister()
 
 uint8_t PPU::readRegister(uint16_t address)
 {
-    static int cycle = 0;
     switch(address)
     {
     // PPUSTATUS
     case 0x2002:
         writeToggle = false;
-        return (cycle++ % 2 == 0 ? 0xc0 : 0);
+        return (statusReads++ % 2 == 0 ? 0xc0 : 0);
     // OAMDATA
     case 0x2004:
         return oam[oamAddress];
@@ -187,6 +272,49 @@ uint8_t PPU::readRegister(uint16_t address)
     return 0;
 }
 
+bool PPU::readState(FILE* file)
+{
+    uint8_t registers[10];
+    uint32_t reads;
+    if (fread(registers, sizeof(registers), 1, file) != 1 ||
+        fread(&reads, sizeof(reads), 1, file) != 1 ||
+        fread(palette, sizeof(palette), 1, file) != 1 ||
+        fread(nametable, sizeof(nametable), 1, file) != 1 ||
+        fread(oam, sizeof(oam), 1, file) != 1)
+    {
+        return false;
+    }
+
+    ppuCtrl = registers[0];
+    ppuMask = registers[1];
+    ppuStatus = registers[2];
+    oamAddress = registers[3];
+    ppuScrollX = registers[4];
+    ppuScrollY = registers[5];
+    currentAddress = registers[6] | (registers[7] << 8);
+    writeToggle = registers[8] != 0;
+    vramBuffer = registers[9];
+    statusReads = reads;
+    return true;
+}
+
+void PPU::reset()
+{
+    ppuCtrl = 0;
+    ppuMask = 0;
+    ppuStatus = 0;
+    oamAddress = 0;
+    ppuScrollX = 0;
+    ppuScrollY = 0;
+    memset(palette, 0, sizeof(palette));
+    memset(nametable, 0, sizeof(nametable));
+    memset(oam, 0, sizeof(oam));
+    vramBuffer = 0;
+    currentAddress = 0;
+    writeToggle = false;
+    statusReads = 0;
+}
+
 void PPU::renderTile(uint32_t* buffer, int index, int xOffset, int yOffset)
 {
     // Lookup the pattern table entry
@@ -511,6 +639,17 @@ void PPU::writeDataRegister(uint8_t value)
 
 void PPU::writeDMA(uint8_t page)
 {
+    // Pages in RAM (and its mirrors) can be copied directly, wrapping around
+    // the end of OAM like the loop below
+    //
+    if (page < 0x20)
+    {
+        const uint8_t* source = engine.ram + (((uint16_t)page << 8) & 0x7ff);
+        memcpy(oam + oamAddress, source, 256 - oamAddress);
+        memcpy(oam, source + 256 - oamAddress, oamAddress);
+        return;
+    }
+
     uint16_t address = (uint16_t)page << 8;
     for (int i = 0; i < 256; i++)
     {
@@ -520,6 +659,68 @@ void PPU::writeDMA(uint8_t page)
     }
 }
 
+bool PPU::writeState(FILE* file) const
+{
+    uint8_t registers[10] = {
+        ppuCtrl,
+        ppuMask,
+        ppuStatus,
+        oamAddress,
+        ppuScrollX,
+        ppuScrollY,
+        (uint8_t)(currentAddress & 0xff),
+        (uint8_t)(currentAddress >> 8),
+        writeToggle,
+        vramBuffer
+    };
+    uint32_t reads = statusReads;
+    return fwrite(registers, sizeof(registers), 1, file) == 1 &&
+        fwrite(&reads, sizeof(reads), 1, file) == 1 &&
+        fwrite(palette, sizeof(palette), 1, file) == 1 &&
+        fwrite(nametable, sizeof(nametable), 1, file) == 1 &&
+        fwrite(oam, sizeof(oam), 1, file) == 1;
+}
+
+void PPU::writeVRAMRun(uint16_t address, const uint8_t* source, int length, int stride)
+{
+    currentAddress = address + length * stride;
+
+    while (length > 0)
+    {
+        address &= 0x3fff;
+        if (address >= 0x2000 && address < 0x3f00)
+        {
+            // Resolve the mirroring once for the part of the run that stays
+            // within one nametable
+            //
+            int remaining = ((address >= 0x3c00) ? 0x300 : 0x400) - (address & 0x3ff);
+            int count = std::min(length, (remaining + stride - 1) / stride);
+            uint8_t* destination = nametable + getNametableIndex(address);
+            if (stride == 1)
+            {
+                memcpy(destination, source, count);
+            }
+            else
+            {
+                for (int i = 0; i < count; i++)
+                {
+                    destination[i * stride] = source[i];
+                }
+            }
+
+            source += count;
+            length -= count;
+            address += count * stride;
+        }
+        else
+        {
+            writeByte(address, *source++);
+            length--;
+            address += stride;
+        }
+    }
+}
+
 void PPU::writeRegister(uint16_t address, uint8_t value)
 {
     switch(address)
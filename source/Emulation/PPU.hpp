@@ -2,21 +2,67 @@
 #define PPU_HPP
 
 #include <cstdint>
-
-//#include <iostream>
+#include <cstdio>
+#include <iosfwd>
 
 class SMBEngine;
 
+/**
+ * Arrangement of the two nametables in the four nametable address ranges
+ * ($2000, $2400, $2800 and $2c00).
+ */
+enum NametableMirroring
+{
+    MIRRORING_HORIZONTAL, /**< Tables 0, 0, 1, 1: $2000 and $2400 share a table. */
+    MIRRORING_VERTICAL    /**< Tables 0, 1, 0, 1: $2000 and $2800 share a table (Super Mario Bros.). */
+};
+
 /**
  * Emulates the NES Picture Processing Unit.
  */
 class PPU
 {
 public:
-    explicit PPU(SMBEngine& engine);
+    explicit PPU(SMBEngine& engine, NametableMirroring mirroring = MIRRORING_VERTICAL);
+
+    /**
+     * Compare the state the game writes (nametables, palette, OAM, VRAM
+     * address and write toggle, control, mask and scroll registers) with the
+     * expected state of another PPU, and print the first difference.
+     *
+     * @param expected the PPU with the expected state.
+     * @param name the name of the code that produced this state, for the message.
+     * @param stream the stream to print the difference to.
+     * @return true if the states match.
+     */
+    bool compareState(const PPU& expected, const char* name, std::ostream& stream) const;
+
+    /**
+     * Copy the complete state of another PPU.
+     */
+    void copyState(const PPU& source);
+
+    /**
+     * Copy everything needed for rendering (control registers, scroll, palette,
+     * nametables and OAM) from another PPU, so that a frame can be rendered
+     * from the copy while the original keeps running.
+     */
+    void copyRenderState(const PPU& source);
 
     uint8_t readRegister(uint16_t address);
 
+    /**
+     * Read the complete state (as copied by copyState()) written by writeState().
+     *
+     * @return false if the file ended early.
+     */
+    bool readState(FILE* file);
+
+    /**
+     * Return to the power-on state. The nametable mirroring is kept.
+     */
+    void reset();
+
     /**
      * Render to a frame buffer.
      */
@@ -30,6 +76,25 @@ public:
 
     void writeRegister(uint16_t address, uint8_t value);
 
+    /**
+     * Write the complete state (as copied by copyState()) to a file.
+     *
+     * @return false if the state could not be written.
+     */
+    bool writeState(FILE* file) const;
+
+    /**
+     * Write a run of bytes to VRAM, with the same result as writing them to
+     * PPUDATA one after another from the given address. The VRAM address is
+     * left after the end of the run.
+     *
+     * @param address the VRAM address of the first byte.
+     * @param source the bytes to write.
+     * @param length the number of bytes to write.
+     * @param stride the VRAM address increment after each byte (1 or 32).
+     */
+    void writeVRAMRun(uint16_t address, const uint8_t* source, int length, int stride);
+
 private:
     SMBEngine& engine;
 
@@ -49,6 +114,9 @@ private:
     bool writeToggle; /**< Toggles whether the low or high bit of the current address will be set on the next write to PPUADDR. */
     uint8_t vramBuffer; /**< Stores the last read byte from VRAM to delay reads by 1 byte. */
 
+    unsigned int statusReads; /**< Number of PPUSTATUS reads, used to alternate the reported vblank/sprite 0 flags. */
+    uint8_t mirroringShift; /**< Right shift that moves the address bit selecting the nametable to bit 10. */
+
     uint8_t getAttributeTableValue(uint16_t nametableAddress);
     uint16_t getNametableIndex(uint16_t address);
     uint8_t readByte(uint16_t address);
@@ -0,0 +1,166 @@
+#ifndef REGISTER_HPP
+#define REGISTER_HPP
+
+#include <cstdint>
+
+/**
+ * Force inlining of the register operations, even in the very large code() function.
+ */
+#define REGISTER_INLINE [[gnu::always_inline]]
+
+/**
+ * Wraps a CPU register (A, X or Y) so that status flags can be set for branch operations.
+ *
+ * Unlike MemoryAccess, the register value is held in the object itself and
+ * every operation is inline, so a Register that is a local variable can live
+ * in a machine register. The engine keeps the flags (its c, z and n members)
+ * and its own copy of the register (registerA and so on), which SMBEngine::code()
+ * brings up to date with STORE_REGISTERS() and LOAD_REGISTERS() wherever other
+ * code uses it.
+ *
+ * @tparam CPU the class that holds the flags (SMBEngine). Only instantiated
+ * where that class is complete.
+ */
+template <class CPU>
+class Register
+{
+public:
+    explicit Register(CPU& cpu, uint8_t value) :
+        value(value),
+        cpu(cpu)
+    {
+    }
+
+    Register(const Register&) = delete;
+
+    /**
+     * Set the value without changing the flags.
+     */
+    REGISTER_INLINE void set(uint8_t newValue) { value = newValue; }
+
+    REGISTER_INLINE Register& operator = (uint8_t rhs)
+    {
+        value = rhs;
+        setZN();
+        return *this;
+    }
+
+    REGISTER_INLINE Register& operator = (const Register& rhs)
+    {
+        return (*this) = rhs.value;
+    }
+
+    REGISTER_INLINE Register& operator += (uint8_t rhs)
+    {
+        uint16_t temp = value + rhs + (cpu.c ? 1 : 0);
+        value = temp & 0xff;
+        setZN();
+        cpu.c = temp > 0xff;
+        return *this;
+    }
+
+    REGISTER_INLINE Register& operator -= (uint8_t rhs)
+    {
+        uint16_t temp = value - rhs - (cpu.c ? 0 : 1);
+        value = temp & 0xff;
+        setZN();
+        cpu.c = temp < 0x100;
+        return *this;
+    }
+
+    REGISTER_INLINE Register& operator ++ ()
+    {
+        value++;
+        setZN();
+        return *this;
+    }
+
+    REGISTER_INLINE Register& operator -- ()
+    {
+        value--;
+        setZN();
+        return *this;
+    }
+
+    REGISTER_INLINE Register& operator ++ (int) { return ++(*this); }
+    REGISTER_INLINE Register& operator -- (int) { return --(*this); }
+
+    REGISTER_INLINE Register& operator &= (uint8_t rhs)
+    {
+        value &= rhs;
+        setZN();
+        return *this;
+    }
+
+    REGISTER_INLINE Register& operator |= (uint8_t rhs)
+    {
+        value |= rhs;
+        setZN();
+        return *this;
+    }
+
+    REGISTER_INLINE Register& operator ^= (uint8_t rhs)
+    {
+        value ^= rhs;
+        setZN();
+        return *this;
+    }
+
+    REGISTER_INLINE Register& operator <<= (int shift)
+    {
+        for (int i = 0; i < shift; i++)
+        {
+            cpu.c = (value & (1 << 7)) != 0;
+            value <<= 1;
+            setZN();
+        }
+        return *this;
+    }
+
+    REGISTER_INLINE Register& operator >>= (int shift)
+    {
+        for (int i = 0; i < shift; i++)
+        {
+            cpu.c = (value & (1 << 0)) != 0;
+            value >>= 1;
+            setZN();
+        }
+        return *this;
+    }
+
+    REGISTER_INLINE operator uint8_t() const { return value; }
+
+    /**
+     * Circular left bit rotation.
+     */
+    REGISTER_INLINE void rol()
+    {
+        bool bit7 = (value & (1 << 7)) != 0;
+        value = (value << 1) | (cpu.c ? (1 << 0) : 0);
+        cpu.c = bit7;
+        setZN();
+    }
+
+    /**
+     * Circular right bit rotation.
+     */
+    REGISTER_INLINE void ror()
+    {
+        bool bit0 = (value & (1 << 0)) != 0;
+        value = (value >> 1) | (cpu.c ? (1 << 7) : 0);
+        cpu.c = bit0;
+        setZN();
+    }
+
+private:
+    uint8_t value;
+    CPU& cpu;
+
+    REGISTER_INLINE void setZN()
+    {
+        cpu.z = (value == 0);
+        cpu.n = (value & (1 << 7)) != 0;
+    }
+};
+
+#endif // REGISTER_HPP
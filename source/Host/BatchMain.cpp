@@ -0,0 +1,57 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "../Util/AreaCache.hpp"
+#include "../Util/AreaParserBenchmark.hpp"
+#include "../Util/BatchRunner.hpp"
+#include "../Util/RomImage.hpp"
+
+#define DEFAULT_INSTANCES 256 // Engines in the batch if none are given
+#define DEFAULT_FRAMES 600    // Frames stepped per engine if none are given
+
+/**
+ * Command line front end of the host build (make host). Runs the batch
+ * scaling benchmark or the area parser benchmark without video, audio or
+ * input, so they can be measured on a build machine.
+ */
+int main(int argc, char** argv)
+{
+    bool areaParser = (argc == 3 && strcmp(argv[1], "--area-parser") == 0);
+    if (argc < 2 || (!areaParser && argv[1][0] == '-'))
+    {
+        std::cout << "Usage: " << argv[0] << " <rom file> [instances] [frames] [max threads]\n"
+            << "       " << argv[0] << " --area-parser <rom file>\n"
+            << "Steps a batch of engines with 1 thread up to max threads (default: one per\n"
+            << "hardware thread) and prints the frames per second and scaling efficiency.\n"
+            << "--area-parser decodes every area with the native and the decompiled area\n"
+            << "parser, checks that the results and the area cache match, and prints the\n"
+            << "time per column.\n";
+        return 1;
+    }
+
+    RomImage romImage;
+    if (!romImage.load(argv[areaParser ? 2 : 1]))
+    {
+        return 1;
+    }
+
+    if (areaParser)
+    {
+        AreaCache areaCache;
+        return measureAreaParser(romImage, areaCache, std::cout) == 0 ? 0 : 1;
+    }
+
+    int instanceCount = (argc > 2) ? atoi(argv[2]) : DEFAULT_INSTANCES;
+    int frameCount = (argc > 3) ? atoi(argv[3]) : DEFAULT_FRAMES;
+    int maxThreads = (argc > 4) ? atoi(argv[4]) : 0;
+    if (instanceCount <= 0 || frameCount <= 0)
+    {
+        std::cout << "The number of instances and frames must be positive.\n";
+        return 1;
+    }
+
+    measureBatchScaling(romImage, instanceCount, frameCount, std::cout, maxThreads);
+
+    return 0;
+}
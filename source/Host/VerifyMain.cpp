@@ -0,0 +1,123 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "../Configuration.hpp"
+#include "../SMB/SMBEngine.hpp"
+#include "../Util/RomImage.hpp"
+
+#define DEFAULT_FRAMES 3600  // Frames played while recording if none are given
+#define DEFAULT_INTERVAL 10  // Record the native calls of every 10th frame if no interval is given
+#define START_PRESS_FRAME 40 // Frame on which Start is pressed to leave the title screen
+
+/**
+ * Play the game with scripted input, checking every native routine against
+ * the decompiled code as it runs, and record the calls of every interval'th frame.
+ */
+static bool record(SMBEngine& engine, const char* fileName, int frameCount, int interval)
+{
+    FILE* file = fopen(fileName, "wb");
+    if (file == nullptr)
+    {
+        std::cout << "Failed to create \"" << fileName << "\".\n";
+        return false;
+    }
+
+    // Leave the title screen, then run right with pseudo-random jumps and fire
+    //
+    engine.reset();
+    uint32_t random = 1;
+    uint8_t buttons = 0;
+    for (int frame = 0; frame < frameCount; frame++)
+    {
+        if (frame == START_PRESS_FRAME)
+        {
+            buttons = 1 << BUTTON_START;
+        }
+        else if (frame > START_PRESS_FRAME && (frame & 15) == 0)
+        {
+            random = random * 1664525 + 1013904223;
+            buttons = (1 << BUTTON_RIGHT) | ((random >> 24) & ((1 << BUTTON_A) | (1 << BUTTON_B)));
+        }
+        engine.getController1().setButtons(buttons);
+
+        engine.setNativeCallRecording((frame % interval == 0) ? file : nullptr);
+        engine.update();
+    }
+    engine.setNativeCallRecording(nullptr);
+
+    long length = ftell(file);
+    fclose(file);
+    std::cout << "Recorded " << length << " bytes from " << frameCount << " frames to \"" << fileName << "\".\n";
+
+    unsigned int mismatches = engine.getNativeMismatches();
+    if (mismatches > 0)
+    {
+        std::cout << mismatches << " native routine calls differed from the decompiled code.\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Replay recorded native calls through the decompiled and the native code.
+ */
+static bool replay(SMBEngine& engine, const char* fileName)
+{
+    FILE* file = fopen(fileName, "rb");
+    if (file == nullptr)
+    {
+        std::cout << "Failed to open \"" << fileName << "\".\n";
+        return false;
+    }
+
+    int mismatches = engine.replayNativeCalls(file, std::cout);
+    fclose(file);
+    return mismatches == 0;
+}
+
+/**
+ * Command line front end of the host build (make host) for the differential
+ * checks of the native routines. Built with SMB_VERIFY_NATIVE, so every native
+ * routine is also checked live while recording.
+ */
+int main(int argc, char** argv)
+{
+    bool recording = (argc >= 4 && strcmp(argv[1], "record") == 0);
+    bool replaying = (argc == 4 && strcmp(argv[1], "replay") == 0);
+    if (!recording && !replaying)
+    {
+        std::cout << "Usage: " << argv[0] << " record <rom file> <recording> [frames] [interval]\n"
+            << "       " << argv[0] << " replay <rom file> <recording>\n"
+            << "record plays the game with scripted input, checks every native routine call\n"
+            << "and saves the state at the calls of every interval'th frame. replay runs the\n"
+            << "saved calls through the decompiled and the native routines and compares them.\n";
+        return 1;
+    }
+
+    RomImage romImage;
+    if (!romImage.load(argv[2]))
+    {
+        return 1;
+    }
+
+    RuntimeConfig config = Configuration::getRuntimeConfig();
+    config.audioEnabled = false;
+    SMBEngine* engine = new SMBEngine(romImage, config);
+
+    bool success;
+    if (recording)
+    {
+        int frameCount = (argc > 4) ? atoi(argv[4]) : DEFAULT_FRAMES;
+        int interval = (argc > 5) ? atoi(argv[5]) : DEFAULT_INTERVAL;
+        success = frameCount > 0 && interval > 0 && record(*engine, argv[3], frameCount, interval);
+    }
+    else
+    {
+        success = replay(*engine, argv[3]);
+    }
+
+    delete engine;
+    return success ? 0 : 1;
+}
@@ -3,8 +3,19 @@
 
 #include <SDL/SDL.h>
 
+#include "Emulation/APU.hpp"
+#include "Emulation/APUTrace.hpp"
 #include "Emulation/Controller.hpp"
 #include "SMB/SMBEngine.hpp"
+#include "Util/AreaCache.hpp"
+#include "Util/AreaParserBenchmark.hpp"
+#include "Util/AudioRenderer.hpp"
+#include "Util/BatchRunner.hpp"
+#include "Util/FramePacer.hpp"
+#include "Util/InputMapping.hpp"
+#include "Util/RenderPipeline.hpp"
+#include "Util/RomImage.hpp"
+#include "Util/Timer.hpp"
 #include "Util/Video.hpp"
 
 #include "Configuration.hpp"
@@ -13,41 +24,33 @@
 #include "3ds.h"
 #include <dirent.h>
 
-uint8_t* romImage;
+static RomImage romImage;
+static AreaCache areaCache;
 static SDL_Surface* texture;
 static SDL_Surface* scanlineTexture;
 static SMBEngine* smbEngine = nullptr;
-static uint32_t renderBuffer[RENDER_WIDTH * RENDER_HEIGHT];
-
-Thread drawThread;
-bool running = true;
-u32 kDown;
-u32 kUp;
+static APUTraceRecorder traceRecorder;
+static FramePacer* framePacer = nullptr;
+static RenderPipeline* renderPipeline = nullptr;
 
 /**
- * Load the Super Mario Bros. ROM image.
+ * Maximum number of frames that can be run ahead.
  */
-static bool loadRomImage()
-{
-    FILE* file = fopen(Configuration::getRomFileName().c_str(), "r");
-    if (file == NULL)
-    {
-        std::cout << "Failed to open the file \"" << Configuration::getRomFileName() << "\". Exiting.\n";
-        return false;
-    }
+#define MAX_RUN_AHEAD_FRAMES 2
 
-    // Find the size of the file
-    fseek(file, 0L, SEEK_END);
-    size_t fileSize = ftell(file);
-    fseek(file, 0L, SEEK_SET);
+/**
+ * Frames between the game reading a button and the response reaching the PPU.
+ * The NMI handler uploads sprites and VRAM before it runs the game logic, so
+ * the effect of input is only visible on the following frame.
+ */
+#define GAME_INPUT_LAG_FRAMES 1
 
-    // Read the entire file into a buffer
-    romImage = new uint8_t[fileSize];
-    fread(romImage, sizeof(uint8_t), fileSize, file);
-    fclose(file);
+/**
+ * Keys whose presses are used to measure input latency.
+ */
+#define LATENCY_KEYS (KEY_A | KEY_B | KEY_DUP | KEY_DDOWN | KEY_DLEFT | KEY_DRIGHT)
 
-    return true;
-}
+bool running = true;
 
 /**
  * SDL Audio callback function.
@@ -70,11 +73,31 @@ static bool initialize()
     Configuration::initialize(CONFIG_FILE_NAME);
 
     // Load the SMB ROM image
-    if (!loadRomImage())
+    if (!romImage.load(Configuration::getRomFileName()))
     {
         return false;
     }
 
+    // Load the decoded areas, or decode them and save them for the next run
+    //
+    const std::string& areaCacheFileName = Configuration::getBatchAreaCacheFileName();
+    if (!areaCacheFileName.empty() && !areaCache.load(areaCacheFileName))
+    {
+        areaCache.build(romImage);
+        if (!areaCache.save(areaCacheFileName))
+        {
+            std::cout << "Failed to save the area cache to " << areaCacheFileName << "\n";
+        }
+    }
+
+    // Rendering audio to a file and the benchmarks run headless
+    //
+    if (!Configuration::getAudioRenderFileName().empty() || Configuration::getBatchInstances() > 0 ||
+        Configuration::getBatchAreaParser())
+    {
+        return true;
+    }
+
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0)
     {
@@ -106,8 +129,8 @@ static bool initialize()
         SDL_AudioSpec desiredSpec;
         desiredSpec.freq = Configuration::getAudioFrequency();
         desiredSpec.format = AUDIO_S8;
-        desiredSpec.channels = 1;
-        desiredSpec.samples = 1024;//2048
+        desiredSpec.channels = Configuration::getAudioStereo() ? 2 : 1;
+        desiredSpec.samples = Configuration::getAudioBufferSamples();
         desiredSpec.callback = audioCallback;
         desiredSpec.userdata = NULL;
 
@@ -125,15 +148,31 @@ static bool initialize()
  */
 static void shutdown()
 {
+    if (renderPipeline != nullptr)
+    {
+        renderPipeline->stop();
+        renderPipeline->printStatistics(std::cout);
+    }
+
     SDL_CloseAudio();
 
+    traceRecorder.close();
+
+    if (framePacer != nullptr)
+    {
+        framePacer->printStatistics(std::cout);
+    }
+
     SDL_FreeSurface(scanlineTexture);
     SDL_FreeSurface(texture);
 
     SDL_Quit();
 }
 
-void drawThreadFunc(void(*))
+/**
+ * Show a rendered frame. Called on the render thread.
+ */
+static void presentFrame(const uint32_t* buffer)
 {
     int i = 0;
     for (int y = 0; y < RENDER_HEIGHT; y++)
@@ -141,146 +180,222 @@ void drawThreadFunc(void(*))
         for (int x = 0; x < RENDER_WIDTH; x++)
         {
             Uint8* pixel = static_cast<Uint8*>(texture->pixels + y * texture->pitch + x * 3);
-            *(Uint32*)(pixel) = renderBuffer[i];
+            *(Uint32*)(pixel) = buffer[i];
             //*(Uint32*)pixel = 0xFFFFFF; //Full white screen.
             i++;
         }
     }
 
-    smbEngine->renderBGColor(renderBuffer);
-    smbEngine->renderBGObj(renderBuffer);
+    SDL_Flip(texture);
+}
+
+/**
+ * Configure the APU output and start tracing it, if enabled.
+ */
+static void initializeAudio(APU& apu)
+{
+    if (Configuration::getAudioStereo())
+    {
+        apu.setOutputMode(AUDIO_OUTPUT_STEREO);
+    }
+
+    if (!Configuration::getAudioTraceFileName().empty())
+    {
+        if (traceRecorder.open(Configuration::getAudioTraceFileName()))
+        {
+            apu.setTraceRecorder(&traceRecorder);
+        }
+        else
+        {
+            std::cout << "Unable to open APU trace file \"" << Configuration::getAudioTraceFileName() << "\"\n";
+        }
+    }
+}
+
+/**
+ * Render game audio to a WAV file as fast as possible, without video.
+ */
+static bool renderAudio()
+{
+    AudioRenderStats stats;
+    bool success;
+
+    if (!Configuration::getAudioReplayFileName().empty())
+    {
+        // Replay a recorded trace into the APU alone
+        //
+        success = renderTraceToFile(Configuration::getAudioReplayFileName(), Configuration::getAudioRenderFileName(), Configuration::getAudioStereo(), &stats);
+    }
+    else
+    {
+        SMBEngine* engine = new SMBEngine(romImage, Configuration::getRuntimeConfig());
+        engine->reset();
+        initializeAudio(engine->getAPU());
+
+        success = renderAudioToFile(*engine, Configuration::getAudioRenderFileName(), Configuration::getAudioRenderFrames(), &stats);
+        traceRecorder.close();
+
+        const APUStatistics& apuStats = engine->getAPU().getStatistics();
+        std::cout << apuStats.silentFrames << " of " << apuStats.frames << " frames silent; active frames per channel:";
+        for (int channel = 0; channel < AUDIO_MAX_CHANNELS; channel++)
+        {
+            std::cout << " " << apuStats.activeFrames[channel];
+        }
+        std::cout << "\n";
+        delete engine;
+    }
+
+    if (!success)
+    {
+        std::cout << "Failed to write audio to \"" << Configuration::getAudioRenderFileName() << "\".\n";
+        return false;
+    }
+
+    std::cout << "Rendered " << stats.frames << " frames (" << stats.bytes << " bytes) in " << stats.totalSeconds << " s\n";
+    if (stats.totalSeconds > 0.0 && stats.updateSeconds > 0.0)
+    {
+        std::cout << stats.frames / stats.totalSeconds << " frames/s overall, " << stats.frames / stats.updateSeconds << " frames/s emulated\n";
+    }
+
+    return true;
 }
 
 static void mainLoop()
 {
-    static SMBEngine engine(romImage); //Static to fit into stack.
+    static SMBEngine engine(romImage, Configuration::getRuntimeConfig()); // Shared with the audio callback and the render thread
     smbEngine = &engine;
     engine.reset();
+    initializeAudio(engine.getAPU());
+
+    static FramePacer pacer(Configuration::getFrameRate(), Configuration::getVsyncEnabled());
+    framePacer = &pacer;
+
+    // Rendering and presentation of frame N run on another core while frame N + 1 is updated
+    //
+    static RenderPipeline pipeline(engine, presentFrame);
+    if (Configuration::getRenderThreadEnabled() && pipeline.start(getRenderCore()))
+    {
+        renderPipeline = &pipeline;
+    }
+
+    // Run-ahead: after each real frame, run a few more frames with the same input
+    // and show the result, then rewind. This hides the game's own input lag.
+    //
+    int runAhead = Configuration::getRunAheadFrames();
+    runAhead = (runAhead < 0) ? 0 : ((runAhead > MAX_RUN_AHEAD_FRAMES) ? MAX_RUN_AHEAD_FRAMES : runAhead);
+    static SMBEngineState runAheadState(engine);
+
+    // Frameskip: only every (frameSkip + 1)th frame is rendered
+    //
+    int frameSkip = (Configuration::getFrameSkip() < 0) ? 0 : Configuration::getFrameSkip();
+    int skippedFrames = 0;
 
-    
-    int progStartTime = SDL_GetTicks();
-    int frame = 0;
-    
     Controller& controller1 = engine.getController1();
+    Controller& controller2 = engine.getController2();
+
+    static InputMapping inputMapping;
+    bool validMapping = inputMapping.parse(Configuration::getInputPlayer1(), 0);
+    validMapping = inputMapping.parse(Configuration::getInputPlayer2(), 1) && validMapping;
+    if (!validMapping)
+    {
+        std::cout << "Ignoring invalid entries in the input mapping\n";
+    }
+    u32 previousKeys = 0;
+    int latencyCountdown = -1;  // Frames until the response to a measured press is shown, or -1
+    uint64_t latencyInputTicks = 0;
 
     while (running)
     {
-        drawThread = threadCreate(drawThreadFunc, 0x0, 2*1024, 0x18, 1, true);
+        /**
+         * Ensure that the framerate stays as close to the desired FPS as possible. If the frame was rendered faster, then delay. 
+         * If the frame was slower, the pacer counts a missed deadline and restarts its schedule so that the game doesn't
+         * try to "catch up", going super-speed.
+         *
+         * Sleeping happens first so that input is sampled as late as possible before the update.
+         */
+        pacer.waitForNextFrame();
+
         SDL_Event event;
         while (SDL_PollEvent(&event))
+        {
+        }
 
         //Scan all the inputs. This should be done once for each frame
 		hidScanInput();
-		//hidKeysDown returns information about which buttons have been just pressed (and they weren't in the previous frame)
-		u32 kDown = hidKeysDown();
-		//hidKeysUp returns information about which buttons have been just released
-		u32 kUp = hidKeysUp();
+        uint64_t inputTicks = getTicks();
+
+        // Derive pressed/released keys from the held state, so other scans (e.g. by SDL) do not hide them
+        //
+        u32 keys = hidKeysHeld();
+        u32 kDown = keys & ~previousKeys;
+        previousKeys = keys;
+
+        // One table lookup per key byte gives the state of every button on both controllers
+        //
+        uint16_t buttons = inputMapping.translate(keys);
+        controller1.setButtons(buttons & 0xff);
+        controller2.setButtons(buttons >> 8);
 
+        if (kDown & KEY_Y)
         {
-            if (kDown & KEY_START)
-            {
-                controller1.setButtonState(BUTTON_START, true);
-            }
-            if (kUp & KEY_START)
-            {
-                controller1.setButtonState(BUTTON_START, false);
-            }
-            if (kDown & KEY_SELECT)
-            {
-                controller1.setButtonState(BUTTON_SELECT, true);
-            }
-            if (kUp & KEY_SELECT)
-            {
-                controller1.setButtonState(BUTTON_SELECT, false);
-            }
-            if (kDown & KEY_A)
-            {
-                controller1.setButtonState(BUTTON_A, true);
-            }
-            if (kUp & KEY_A)
-            {
-                controller1.setButtonState(BUTTON_A, false);
-            }
-            if (kDown & KEY_B)
-            {
-                controller1.setButtonState(BUTTON_B, true);
-            }
-            if (kUp & KEY_B)
-            {
-                controller1.setButtonState(BUTTON_B, false);
-            }
-            /*if (kDown & KEY_X)
-            {
-                
-            }
-            if (kUp & KEY_X)
-            {
-                
-            }*/
-            if (kDown & KEY_Y)
-            {
-                shutdown();
-                exit(0);
-            }
-            /*if (kUp & KEY_Y)
-            {
-                
-            }*/
-            if (kDown & KEY_DLEFT)
-            {
-                controller1.setButtonState(BUTTON_LEFT, true);
-            }
-            if (kUp & KEY_DLEFT)
-            {
-                controller1.setButtonState(BUTTON_LEFT, false);
-            }
-            if (kDown & KEY_DRIGHT)
-            {
-                controller1.setButtonState(BUTTON_RIGHT, true);
-            }
-            if (kUp & KEY_DRIGHT)
-            {
-                controller1.setButtonState(BUTTON_RIGHT, false);
-            }
-            if (kDown & KEY_DUP)
-            {
-                controller1.setButtonState(BUTTON_UP, true);
-            }
-            if (kUp & KEY_DUP)
-            {
-                controller1.setButtonState(BUTTON_UP, false);
-            }
-            if (kDown & KEY_DDOWN)
-            {
-            controller1.setButtonState(BUTTON_DOWN, true);
-            }
-            if (kUp & KEY_DDOWN)
+            shutdown();
+            exit(0);
+        }
+
+        // Measure how long it takes until the response to a new press is presented
+        //
+        if ((kDown & LATENCY_KEYS) && latencyCountdown < 0)
+        {
+            latencyCountdown = (runAhead < GAME_INPUT_LAG_FRAMES) ? GAME_INPUT_LAG_FRAMES - runAhead : 0;
+            latencyInputTicks = inputTicks;
+        }
+
+        bool renderFrame = (skippedFrames >= frameSkip);
+        skippedFrames = renderFrame ? 0 : skippedFrames + 1;
+
+        uint64_t updateStart = getTicks();
+        engine.update();
+
+        // Running ahead is only needed for frames that are shown
+        //
+        bool runningAhead = (runAhead > 0) && renderFrame;
+        if (runningAhead)
+        {
+            engine.saveState(runAheadState);
+            engine.setAudioSuspended(true);
+            for (int i = 0; i < runAhead; i++)
             {
-                controller1.setButtonState(BUTTON_DOWN, false);
+                engine.update();
             }
         }
 
-        engine.update();
-        
-        /**
-         * Ensure that the framerate stays as close to the desired FPS as possible. If the frame was rendered faster, then delay. 
-         * If the frame was slower, reset time so that the game doesn't try to "catch up", going super-speed.
-         */
-        int now = SDL_GetTicks();
-        int delay = progStartTime + ((frame) * (MS_PER_SEC) / (Configuration::getFrameRate())) - now;
-        if(delay > 0) 
+        if (renderFrame && renderPipeline != nullptr)
+        {
+            renderPipeline->recordUpdateTicks(getTicks() - updateStart);
+            renderPipeline->submitFrame((latencyCountdown == 0) ? latencyInputTicks : 0);
+        }
+        else if (renderFrame)
         {
-            SDL_Delay(delay);
+            static uint32_t renderBuffer[RENDER_WIDTH * RENDER_HEIGHT];
+            engine.renderBGColor(renderBuffer);
+            engine.renderBGObj(renderBuffer);
+            engine.renderBGNT(renderBuffer);
+            engine.renderFGObj(renderBuffer);
+            presentFrame(renderBuffer);
         }
-        else 
+
+        // A measured response is only counted once it is actually shown
+        //
+        if (latencyCountdown > 0 || (latencyCountdown == 0 && renderFrame))
+        {
+            latencyCountdown--;
+        }
+
+        if (runningAhead)
         {
-            frame = 0;
-            progStartTime = now;
+            engine.loadState(runAheadState);
+            engine.setAudioSuspended(false);
         }
-        engine.renderBGNT(renderBuffer);
-        engine.renderFGObj(renderBuffer);
-        SDL_Flip(texture);
-        frame++;
     }
 }
 
@@ -309,6 +424,22 @@ int main(int argc, char** argv)
         return -1;
     }
 
+    if (!Configuration::getAudioRenderFileName().empty())
+    {
+        return renderAudio() ? 0 : -1;
+    }
+
+    if (Configuration::getBatchAreaParser())
+    {
+        return measureAreaParser(romImage, areaCache, std::cout) == 0 ? 0 : 1;
+    }
+
+    if (Configuration::getBatchInstances() > 0)
+    {
+        measureBatchScaling(romImage, Configuration::getBatchInstances(), Configuration::getBatchFrames(), std::cout);
+        return 0;
+    }
+
     mainLoop();
 
     shutdown();
@@ -6,13 +6,41 @@
 //Thanks to Warsen for Restructured code segments.
 void SMBEngine::code(int mode)
 {
+	// Work on copies of the registers, see LOAD_REGISTERS() and STORE_REGISTERS()
+	Register<SMBEngine> a(*this, registerA);
+	Register<SMBEngine> x(*this, registerX);
+	Register<SMBEngine> y(*this, registerY);
+
 	switch (mode)
 	{
 	case 0:
-		loadConstantData();
 		goto Start;
 	case 1:
 		goto NonMaskableInterrupt;
+	case CODE_PROC_ENEMY_COLLISIONS:
+		goto ProcEnemyCollisions;
+	case CODE_ENEMIES_COLLISION:
+		goto EnemiesCollision;
+	case CODE_PROCESS_AREA_DATA:
+		goto ProcessAreaData;
+	case CODE_AREA_PARSER_CORE:
+		goto AreaParserCore;
+	case CODE_INITIALIZE_AREA:
+		goto InitializeArea;
+	case CODE_BLOCK_BUFFER_COLLISION:
+		goto BlockBufferCollisionDecompiled;
+	case CODE_MOVE_SPRITES_OFFSCREEN:
+		goto MoveSpritesOffscreen;
+	case CODE_SPRITE_SHUFFLER:
+		goto SpriteShuffler;
+	case CODE_UPDATE_SCREEN:
+		goto UpdateScreen;
+	case CODE_RENDER_AREA_GRAPHICS:
+		goto RenderAreaGraphics;
+	case CODE_RENDER_ATTRIBUTE_TABLES:
+		goto RenderAttributeTables;
+	case CODE_CHECK_FOR_SOLID_MTILES:
+		goto CheckForSolidMTiles;
 	}
 
 
@@ -22,7 +50,7 @@ Start:
 	a = (0b00010000); // init PPU control register 1 
 	writeData(PPU_CTRL_REG1, a);
 	x = 0xff; // reset stack pointer
-	s = x;
+	registerS = x;
 
 VBlank1: // wait two frames
 	a = M(PPU_STATUS);
@@ -69,6 +97,7 @@ ColdBoot: // clear memory using pointer in Y
 	JSR(WritePPUReg1, 3);
 
 EndlessLoop: // endless loop, need I say more?
+	STORE_REGISTERS();
 	return;
 
 NonMaskableInterrupt:
@@ -100,7 +129,11 @@ ScreenOff: // save bits for later but not in register at the moment
 	writeData(0x00, a);
 	a = M(VRAM_AddrTable_High + x);
 	writeData(0x01, a);
-	JSR(UpdateScreen, 5); // update screen with buffer contents
+#ifdef SMB_VERIFY_NATIVE
+	CALL_NATIVE(verifyNative(CODE_UPDATE_SCREEN));
+#else
+	CALL_NATIVE(updateScreen()); // update screen with buffer contents (native, see SMBNative.cpp)
+#endif
 	y = 0x00;
 	x = M(VRAM_Buffer_AddrCtrl); // check for usage of $0341
 	compare(x, 0x06);
@@ -186,8 +219,13 @@ PauseSkip:
 		a >>= 1;
 		if (!c)
 		{
-			JSR(MoveSpritesOffscreen, 10);
-			JSR(SpriteShuffler, 11);
+#ifdef SMB_VERIFY_NATIVE
+			CALL_NATIVE(verifyNative(CODE_MOVE_SPRITES_OFFSCREEN));
+			CALL_NATIVE(verifyNative(CODE_SPRITE_SHUFFLER));
+#else
+			CALL_NATIVE(moveSpritesOffscreen()); // native, see SMBNative.cpp
+			CALL_NATIVE(spriteShuffler());
+#endif
 		}
 
 		do
@@ -211,7 +249,7 @@ PauseSkip:
 	a = M(VerticalScroll);
 	writeData(PPU_SCROLL_REG, a);
 	a = M(Mirror_PPU_CTRL_REG1); // load saved mirror of $2000
-	pha();
+	pha(a);
 	writeData(PPU_CTRL_REG1, a);
 	a = M(GamePauseStatus); // if in pause mode, do not perform operation mode stuff
 	a >>= 1;
@@ -221,9 +259,10 @@ PauseSkip:
 	}
 	// reset flip-flop
 	a = M(PPU_STATUS);
-	pla();
+	a = pla();
 	a |= (0b10000000); // reactivate NMIs
 	writeData(PPU_CTRL_REG1, a);
+	STORE_REGISTERS();
 	return; // we are done until the next frame!
 
 PauseRoutine:
@@ -955,17 +994,17 @@ InitScreen:
 
 SetupIntermediate:
 	a = M(BackgroundColorCtrl); // save current background color control
-	pha(); // and player status to stack
+	pha(a); // and player status to stack
 	a = M(PlayerStatus);
-	pha();
+	pha(a);
 	a = 0x00; // set background color to black
 	writeData(PlayerStatus, a); // and player status to not fiery
 	a = 0x02; // this is the ONLY time background color control
 	writeData(BackgroundColorCtrl, a); // is set to less than 4
 	JSR(GetPlayerColors, 31);
-	pla(); // we only execute this routine for
+	a = pla(); // we only execute this routine for
 	writeData(PlayerStatus, a); // the intermediate lives display
-	pla(); // and once we're done, we return bg
+	a = pla(); // and once we're done, we return bg
 	writeData(BackgroundColorCtrl, a); // color ctrl and player status from stack
 	++M(ScreenRoutineTask); // then move onto the next task
 	goto Return;
@@ -1214,7 +1253,7 @@ WriteTopScore:
 	goto Return;
 
 WriteGameText:
-	pha(); // save text number to stack
+	pha(a); // save text number to stack
 	a <<= 1;
 	y = a; // multiply by 2 and use as offset
 	compare(y, 0x04); // if set to do top status bar or world/lives display,
@@ -1246,7 +1285,7 @@ WriteGameText:
 	a = 0x00; // put null terminator at end
 	writeData(VRAM_Buffer1 + y, a);
 
-	pla(); // pull original text number from stack
+	a = pla(); // pull original text number from stack
 	x = a;
 	compare(a, 0x04); // are we printing warp zone?
 	if (c)
@@ -1687,9 +1726,9 @@ RemBridge: // write top left and top right
 JumpEngine:
 	a <<= 1; // shift bit from contents of A
 	y = a;
-	pla(); // pull saved return address from stack
+	a = pla(); // pull saved return address from stack
 	writeData(0x04, a); // save to indirect
-	pla();
+	a = pla();
 	writeData(0x05, a);
 	++y;
 	a = M(W(0x04) + y); // load pointer from indirect
@@ -1752,24 +1791,24 @@ ReadPortBits:
 	y = 0x08;
 
 PortLoop: // push previous bit onto stack
-	pha();
+	pha(a);
 	a = M(JOYPAD_PORT + x); // read current bit on joypad port
 	writeData(0x00, a); // check d1 and d0 of port output
 	a >>= 1; // this is necessary on the old
 	a |= M(0x00); // famicom systems in japan
 	a >>= 1;
-	pla(); // read bits from stack
+	a = pla(); // read bits from stack
 	a.rol(); // rotate bit from carry flag
 	--y;
 	if (!z)
 		goto PortLoop; // count down bits left
 	writeData(SavedJoypadBits + x, a); // save controller status here always
-	pha();
+	pha(a);
 	a &= (0b00110000); // check for select or start
 	a &= M(JoypadBitMask + x); // if neither saved state nor current state
 	if (z)
 		goto Save8Bits; // have any of these two set, branch
-	pla();
+	a = pla();
 	a &= (0b11001111); // otherwise store without select
 	writeData(SavedJoypadBits + x, a); // or start bits and leave
 	goto Return;
@@ -1777,7 +1816,7 @@ PortLoop: // push previous bit onto stack
 //------------------------------------------------------------------------
 
 Save8Bits:
-	pla();
+	a = pla();
 	writeData(JoypadBitMask + x, a); // save with all bits in another place and leave
 	goto Return;
 
@@ -1791,7 +1830,7 @@ WriteBufferToScreen:
 	++y;
 	a = M(W(0x00) + y); // load next byte (third)
 	a <<= 1; // shift to left and save in stack
-	pha();
+	pha(a);
 	a = M(Mirror_PPU_CTRL_REG1); // load mirror of $2000,
 	a |= (0b00000100); // set ppu to increment by 32 by default
 	if (c)
@@ -1800,7 +1839,7 @@ WriteBufferToScreen:
 
 SetupWrites: // write to register
 	JSR(WritePPUReg1, 48);
-	pla(); // pull from stack and shift to left again
+	a = pla(); // pull from stack and shift to left again
 	a <<= 1;
 	if (!c)
 		goto GetLength; // if d6 of third byte was clear, do not repeat byte
@@ -1874,7 +1913,7 @@ OutputNumbers:
 	compare(a, 0x06);
 	if (c)
 		goto ExitOutputN;
-	pha(); // save incremented value to stack for now and
+	pha(a); // save incremented value to stack for now and
 	a <<= 1; // shift to left and use as offset
 	y = a;
 	x = M(VRAM_Buffer1_Offset); // get current buffer pointer
@@ -1892,7 +1931,7 @@ SetupNums:
 	writeData(VRAM_Buffer1 + 2 + x, a);
 	writeData(0x03, a); // save length byte in counter
 	writeData(0x02, x); // and buffer pointer elsewhere for now
-	pla(); // pull original incremented value from stack
+	a = pla(); // pull original incremented value from stack
 	x = a;
 	a = M(StatusBarOffset + x); // load offset to value we want to write
 	c = 1;
@@ -2435,10 +2474,10 @@ TransposePlayers:
 
 TransLoop: // transpose the information
 	a = M(OnscreenPlayerInfo + x);
-	pha(); // of the onscreen player
+	pha(a); // of the onscreen player
 	a = M(OffscreenPlayerInfo + x); // with that of the offscreen player
 	writeData(OnscreenPlayerInfo + x, a);
-	pla();
+	a = pla();
 	writeData(OffscreenPlayerInfo + x, a);
 	--x;
 	if (!n)
@@ -2490,7 +2529,7 @@ AreaParserTasks:
 	case 2:
 		goto RenderAreaGraphics;
 	case 3:
-		goto AreaParserCore;
+		goto AreaParserCoreNative;
 	case 4:
 		goto IncrementColumnPos;
 	case 5:
@@ -2498,9 +2537,17 @@ AreaParserTasks:
 	case 6:
 		goto RenderAreaGraphics;
 	case 7:
-		goto AreaParserCore;
+		goto AreaParserCoreNative;
 	}
 
+AreaParserCoreNative:
+#ifdef SMB_VERIFY_NATIVE
+	CALL_NATIVE(verifyNative(CODE_AREA_PARSER_CORE));
+#else
+	CALL_NATIVE(areaParserCore()); // native, see SMBNative.cpp
+#endif
+	goto Return;
+
 IncrementColumnPos:
 	++M(CurrentColumnPos); // increment column where we're at
 	a = M(CurrentColumnPos);
@@ -2559,7 +2606,7 @@ RendBack: // move results to higher nybble
 	a = M(BackSceneryData + x); // load data from sum of offsets
 	if (z)
 		goto RendFore; // if zero, no scenery for that part
-	pha();
+	pha(a);
 	a &= 0x0f; // save to stack and clear high nybble
 	c = 1;
 	a -= 0x01; // subtract one (because low nybble is $01-$0c)
@@ -2567,7 +2614,7 @@ RendBack: // move results to higher nybble
 	a <<= 1; // multiply by three (shift to left and add result to old one)
 	a += M(0x00); // note that since d7 was nulled, the carry flag is always clear
 	x = a; // save as offset for background scenery metatile data
-	pla(); // get high nybble from stack, move low
+	a = pla(); // get high nybble from stack, move low
 	a >>= 1;
 	a >>= 1;
 	a >>= 1;
@@ -2653,7 +2700,7 @@ NoCloud2: // start at beginning of bitmasks
 
 TerrBChk: // load bitmask, then perform AND on contents of first byte
 	a = M(Bitmasks + y);
-	bit(M(0x00));
+	bit(a, M(0x00));
 	if (z)
 		goto NextTBit; // if not set, skip this part (do not write terrain to buffer)
 	a = M(0x07);
@@ -3083,15 +3130,15 @@ AlterAreaAttributes:
 	y = M(AreaObjOffsetBuffer + x); // load offset for level object data saved in buffer
 	++y; // load second byte
 	a = M(W(AreaData) + y);
-	pha(); // save in stack for now
+	pha(a); // save in stack for now
 	a &= (0b01000000);
 	if (!z)
 		goto Alter2; // branch if d6 is set
-	pla();
-	pha(); // pull and push offset to copy to A
+	a = pla();
+	pha(a); // pull and push offset to copy to A
 	a &= (0b00001111); // mask out high nybble and store as
 	writeData(TerrainControl, a); // new terrain height type bits
-	pla();
+	a = pla();
 	a &= (0b00110000); // pull and mask out all but d5 and d4
 	a >>= 1; // move bits to lower nybble and store
 	a >>= 1; // as new background scenery bits
@@ -3103,7 +3150,7 @@ AlterAreaAttributes:
 //------------------------------------------------------------------------
 
 Alter2:
-	pla();
+	a = pla();
 	a &= (0b00000111); // mask out all but 3 LSB
 	compare(a, 0x04); // if four or greater, set color control bits
 	if (!c)
@@ -3288,7 +3335,7 @@ CastleObject:
 	y = 0x04;
 	JSR(ChkLrgObjFixedLength, 80); // load length of castle if not already loaded
 	a = x;
-	pha(); // save obj buffer offset to stack
+	pha(a); // save obj buffer offset to stack
 	y = M(AreaObjectLength + x); // use current length as offset for castle data
 	x = M(0x07); // begin at starting row
 	a = 0x0b;
@@ -3312,7 +3359,7 @@ ChkCFloor: // have we reached the row just before floor?
 	compare(x, 0x0b);
 	if (!z)
 		goto CRendLoop; // if not, go back and do another row
-	pla();
+	a = pla();
 	x = a; // get obj buffer offset from before
 	a = M(CurrentPageLoc);
 	if (z)
@@ -3333,9 +3380,9 @@ NotTall: // if not tall castle, check to see if we're at the third column
 	if (!z)
 		goto ExitCastle; // if we aren't and the castle is tall, don't create flag yet
 	JSR(GetAreaObjXPosition, 81); // otherwise, obtain and save horizontal pixel coordinate
-	pha();
+	pha(a);
 	JSR(FindEmptyEnemySlot, 82); // find an empty place on the enemy object buffer
-	pla();
+	a = pla();
 	writeData(Enemy_X_Position + x, a); // then write horizontal coordinate for star flag
 	a = M(CurrentPageLoc);
 	writeData(Enemy_PageLoc + x, a); // set page location for star flag
@@ -3438,7 +3485,7 @@ VerticalPipe:
 
 WarpPipe: // save value in stack
 	a = y;
-	pha();
+	pha(a);
 	a = M(AreaNumber);
 	a |= M(WorldNumber); // if at world 1-1, do not add piranha plant ever
 	if (z)
@@ -3466,7 +3513,7 @@ WarpPipe: // save value in stack
 	JSR(InitPiranhaPlant, 93);
 
 DrawPipe: // get value saved earlier and use as Y
-	pla();
+	a = pla();
 	y = a;
 	x = M(0x07); // get buffer offset
 	a = M(VerticalPipeData + y); // draw the appropriate pipe with the Y we loaded earlier
@@ -3523,9 +3570,9 @@ QuestionBlockRow_High:
 QuestionBlockRow_Low:
 	a = 0x07; // start on the eighth row
 Skip_1:
-	pha(); // save whatever row to the stack for now
+	pha(a); // save whatever row to the stack for now
 	JSR(ChkLrgObjLength, 97); // get low nybble and save as length
-	pla();
+	a = pla();
 	x = a; // render question boxes with coins
 	a = 0xc0;
 	writeData(MetatileBuffer + x, a);
@@ -3545,9 +3592,9 @@ Skip_2:
 Bridge_Low:
 	a = 0x09; // start on the tenth row
 Skip_3:
-	pha(); // save whatever row to the stack for now
+	pha(a); // save whatever row to the stack for now
 	JSR(ChkLrgObjLength, 98); // get low nybble and save as length
-	pla();
+	a = pla();
 	x = a; // render bridge railing
 	a = 0x0b;
 	writeData(MetatileBuffer + x, a);
@@ -3596,12 +3643,12 @@ EndlessRope:
 
 BalancePlatRope:
 	a = x; // save object buffer offset for now
-	pha();
+	pha(a);
 	x = 0x01; // blank out all from second row to the bottom
 	y = 0x0f; // with blank used for balance platform rope
 	a = 0x44;
 	JSR(RenderUnderPart, 102);
-	pla(); // get back object buffer offset
+	a = pla(); // get back object buffer offset
 	x = a;
 	JSR(GetLrgObjAttrib, 103); // get vertical length from lower nybble
 	x = 0x01;
@@ -3655,13 +3702,13 @@ RowOfSolidBlocks:
 	a = M(SolidBlockMetatiles + y); // get metatile
 
 GetRow: // store metatile here
-	pha();
+	pha(a);
 	JSR(ChkLrgObjLength, 106); // get row number, load length
 
 DrawRow:
 	x = M(0x07);
 	y = 0x00; // set vertical height of 1
-	pla();
+	a = pla();
 	goto RenderUnderPart; // render object
 
 ColumnOfBricks:
@@ -3674,9 +3721,9 @@ ColumnOfSolidBlocks:
 	a = M(SolidBlockMetatiles + y); // get metatile
 
 GetRow2: // save metatile to stack for now
-	pha();
+	pha(a);
 	JSR(GetLrgObjAttrib, 107); // get length and row
-	pla(); // restore metatile
+	a = pla(); // restore metatile
 	x = M(0x07); // get starting row
 	goto RenderUnderPart; // now render the column
 
@@ -3791,7 +3838,7 @@ BWithL: // add object ID to adder
 
 DrawQBlk: // get appropriate metatile for brick (question block
 	a = M(BrickQBlockMetatiles + y);
-	pha(); // if branched to here from question block routine)
+	pha(a); // if branched to here from question block routine)
 	JSR(GetLrgObjAttrib, 119); // get row from location byte
 	goto DrawRow; // now render the object
 
@@ -3939,7 +3986,7 @@ GetAreaObjYPosition:
 //------------------------------------------------------------------------
 
 GetBlockBufferAddr:
-	pha(); // take value of A, save
+	pha(a); // take value of A, save
 	a >>= 1; // move high nybble to low
 	a >>= 1;
 	a >>= 1;
@@ -3947,7 +3994,7 @@ GetBlockBufferAddr:
 	y = a; // use nybble as pointer to high byte
 	a = M(BlockBufferAddr + 2 + y); // of indirect here
 	writeData(0x07, a);
-	pla();
+	a = pla();
 	a &= (0b00001111); // pull from stack, mask out high nybble
 	c = 0;
 	a += M(BlockBufferAddr + y); // add to low byte
@@ -4008,7 +4055,7 @@ GetAreaDataAddrs:
 	writeData(AreaDataHigh, a);
 	y = 0x00; // load first byte of header
 	a = M(W(AreaData) + y);
-	pha(); // save it to the stack for now
+	pha(a); // save it to the stack for now
 	a &= (0b00000111); // save 3 LSB for foreground scenery or bg color control
 	compare(a, 0x04);
 	if (!c)
@@ -4018,14 +4065,14 @@ GetAreaDataAddrs:
 
 StoreFore: // if less, save value here as foreground scenery
 	writeData(ForegroundScenery, a);
-	pla(); // pull byte from stack and push it back
-	pha();
+	a = pla(); // pull byte from stack and push it back
+	pha(a);
 	a &= (0b00111000); // save player entrance control bits
 	a >>= 1; // shift bits over to LSBs
 	a >>= 1;
 	a >>= 1;
 	writeData(PlayerEntranceCtrl, a); // save value here as player entrance control
-	pla(); // pull byte again but do not push it back
+	a = pla(); // pull byte again but do not push it back
 	a &= (0b11000000); // save 2 MSB for game timer setting
 	c = 0;
 	a.rol(); // rotate bits over to LSBs
@@ -4034,18 +4081,18 @@ StoreFore: // if less, save value here as foreground scenery
 	writeData(GameTimerSetting, a); // save value here as game timer setting
 	++y;
 	a = M(W(AreaData) + y); // load second byte of header
-	pha(); // save to stack
+	pha(a); // save to stack
 	a &= (0b00001111); // mask out all but lower nybble
 	writeData(TerrainControl, a);
-	pla(); // pull and push byte to copy it to A
-	pha();
+	a = pla(); // pull and push byte to copy it to A
+	pha(a);
 	a &= (0b00110000); // save 2 MSB for background scenery type
 	a >>= 1;
 	a >>= 1; // shift bits to LSBs
 	a >>= 1;
 	a >>= 1;
 	writeData(BackgroundScenery, a); // save as background scenery
-	pla();
+	a = pla();
 	a &= (0b11000000);
 	c = 0;
 	a.rol(); // rotate bits over to LSBs
@@ -6460,7 +6507,7 @@ ExitPUp: // and we're done
 //------------------------------------------------------------------------
 
 PlayerHeadCollision:
-	pha(); // store metatile number to stack
+	pha(a); // store metatile number to stack
 	a = 0x11; // load unbreakable block object state by default
 	x = M(SprDataOffset_Ctrl); // load offset control bit here
 	y = M(PlayerSize); // check player's size
@@ -6524,7 +6571,7 @@ PutMTileB: // store whatever metatile be appropriate here
 	writeData(W(0x06) + y, a); // write blank metatile $23 to block buffer
 	a = 0x10;
 	writeData(BlockBounceTimer, a); // set block bounce timer
-	pla(); // pull original metatile from stack
+	a = pla(); // pull original metatile from stack
 	writeData(0x05, a); // and save here
 	y = 0x00; // set default offset
 	a = M(CrouchingFlag); // is player crouching?
@@ -6735,7 +6782,7 @@ BlockObjectsCore:
 	if (z)
 		goto UpdSte; // if not set, branch to leave
 	a &= 0x0f; // mask out high nybble
-	pha(); // push to stack
+	pha(a); // push to stack
 	y = a; // put in Y for now
 	a = x;
 	c = 0;
@@ -6756,11 +6803,11 @@ BlockObjectsCore:
 	JSR(RelativeBlockPosition, 259); // get relative coordinates
 	JSR(GetBlockOffscreenBits, 260); // get offscreen information
 	JSR(DrawBrickChunks, 261); // draw the brick chunks
-	pla(); // get lower nybble of saved state
+	a = pla(); // get lower nybble of saved state
 	y = M(Block_Y_HighPos + x); // check vertical high byte of block object
 	if (z)
 		goto UpdSte; // if above the screen, branch to kill it
-	pha(); // otherwise save state back into stack
+	pha(a); // otherwise save state back into stack
 	a = 0xf0;
 	compare(a, M(Block_Y_Position + 2 + x)); // check to see if bottom block object went
 	if (c)
@@ -6770,7 +6817,7 @@ BlockObjectsCore:
 ChkTop: // get top block object's vertical coordinate
 	a = M(Block_Y_Position + x);
 	compare(a, 0xf0); // see if it went to the bottom of the screen
-	pla(); // pull block object state from stack
+	a = pla(); // pull block object state from stack
 	if (!c)
 		goto UpdSte; // if not, branch to save state
 	if (c)
@@ -6785,7 +6832,7 @@ BouncingBlockHandler:
 	a = M(Block_Y_Position + x); // get vertical coordinate
 	a &= 0x0f; // mask out high nybble
 	compare(a, 0x05); // check to see if low nybble wrapped around
-	pla(); // pull state from stack
+	a = pla(); // pull state from stack
 	if (c)
 		goto UpdSte; // if still above amount, not time to kill block yet, thus branch
 	a = 0x01;
@@ -6879,7 +6926,7 @@ UseAdder: // save Y here
 	writeData(SprObject_X_MoveForce + x, a); // store result here
 	a = 0x00; // init A
 	a.rol(); // rotate carry into d0
-	pha(); // push onto stack
+	pha(a); // push onto stack
 	a.ror(); // rotate d0 back onto carry
 	a = M(SprObject_X_Position + x);
 	a += M(0x00); // add carry plus saved value (high nybble moved to low
@@ -6887,7 +6934,7 @@ UseAdder: // save Y here
 	a = M(SprObject_PageLoc + x);
 	a += M(0x02); // add carry plus other saved value to the
 	writeData(SprObject_PageLoc + x, a); // object's page location and save
-	pla();
+	a = pla();
 	c = 0; // pull old carry from stack and add
 	a += M(0x00); // to high nybble moved to low
 
@@ -6993,7 +7040,7 @@ MovePlatformDown:
 MovePlatformUp:
 	a = 0x01; // save value to stack
 Skip_7:
-	pha();
+	pha(a);
 	y = M(Enemy_ID + x); // get enemy object identifier
 	++x; // increment offset for enemy object
 	a = 0x05; // load default value here
@@ -7008,7 +7055,7 @@ SetDplSpd: // save downward movement amount here
 	writeData(0x01, a);
 	a = 0x03; // save maximum vertical speed here
 	writeData(0x02, a);
-	pla(); // get value from stack
+	a = pla(); // get value from stack
 	y = a; // use as Y, then move onto code shared by red koopa
 
 RedPTroopaGrav:
@@ -7019,7 +7066,7 @@ RedPTroopaGrav:
 //------------------------------------------------------------------------
 
 ImposeGravity:
-	pha(); // push value to stack
+	pha(a); // push value to stack
 	a = M(SprObject_YMF_Dummy + x);
 	c = 0; // add value in movement force to contents of dummy variable
 	a += M(SprObject_Y_MoveForce + x);
@@ -7057,7 +7104,7 @@ AlterYP: // store Y here
 	writeData(SprObject_Y_MoveForce + x, a); // clear fractional
 
 ChkUpM: // get value from stack
-	pla();
+	a = pla();
 	if (z)
 		goto ExVMove; // if set to zero, branch to leave
 	a = M(0x02);
@@ -7091,11 +7138,11 @@ ExVMove: // leave!
 
 EnemiesAndLoopsCore:
 	a = M(Enemy_Flag + x); // check data here for MSB set
-	pha(); // save in stack
+	pha(a); // save in stack
 	a <<= 1;
 	if (c)
 		goto ChkBowserF; // if MSB set in enemy flag, branch ahead of jumps
-	pla(); // get from stack
+	a = pla(); // get from stack
 	if (z)
 		goto ChkAreaTsk; // if data zero, branch
 	goto RunEnemyObjectsCore; // otherwise, jump to run enemy subroutines
@@ -7109,7 +7156,7 @@ ChkAreaTsk: // check number of tasks to perform
 	goto ProcLoopCommand; // otherwise, jump to process loop command/load enemies
 
 ChkBowserF: // get data from stack
-	pla();
+	a = pla();
 	a &= (0b00001111); // mask out high nybble
 	y = a;
 	a = M(Enemy_Flag + y); // use as pointer and load same place with different offset
@@ -7900,7 +7947,7 @@ MaxCC: // store whatever pseudorandom bits are in Y
 	a <<= 1; // otherwise, multiply A by 2
 
 GSeed: // save to stack
-	pha();
+	pha(a);
 	c = 0;
 	a += M(0x00); // add to last two bits of LSFR we saved earlier
 	writeData(0x00, a); // save it there
@@ -7913,7 +7960,7 @@ GSeed: // save to stack
 	writeData(0x00, a); // third LSFR part
 
 RSeed: // get value from stack we saved earlier
-	pla();
+	a = pla();
 	c = 0;
 	a += M(0x01); // add to last two bits of LSFR we saved in other place
 	y = a; // use as pseudorandom offset here
@@ -8117,7 +8164,7 @@ StarFChk:
 	a = M(Enemy_X_Position + y);
 	c = 1; // get horizontal coordinate of star flag object, then
 	a -= 0x30; // subtract 48 pixels from it and save to
-	pha(); // the stack
+	pha(a); // the stack
 	a = M(Enemy_PageLoc + y);
 	a -= 0x00; // subtract the carry from the page location
 	writeData(0x00, a); // of the star flag object
@@ -8125,7 +8172,7 @@ StarFChk:
 	c = 0;
 	a += M(Enemy_State + y); // add state of star flag object (possibly not necessary)
 	y = a; // use as offset
-	pla(); // get saved horizontal coordinate of star flag - 48 pixels
+	a = pla(); // get saved horizontal coordinate of star flag - 48 pixels
 	c = 0;
 	a += M(FireworksXPosData + y); // add number based on offset of fireworks counter
 	writeData(Enemy_X_Position + x, a); // store as the fireworks object horizontal coordinate
@@ -8193,7 +8240,7 @@ GetRBit: // get first part of LSFR
 ChkRBit: // use as offset
 	y = a;
 	a = M(Bitmasks + y); // load bitmask
-	bit(M(BitMFilter)); // perform AND on filter without changing it
+	bit(a, M(BitMFilter)); // perform AND on filter without changing it
 	if (z)
 		goto AddFBit;
 	++y; // increment offset
@@ -8244,11 +8291,11 @@ HandleGroupEnemies:
 	y = 0x00; // load value for green koopa troopa
 	c = 1;
 	a -= 0x37; // subtract $37 from second byte read
-	pha(); // save result in stack for now
+	pha(a); // save result in stack for now
 	compare(a, 0x04); // was byte in $3b-$3e range?
 	if (c)
 		goto SnglID; // if so, branch
-	pha(); // save another copy to stack
+	pha(a); // save another copy to stack
 	y = Goomba; // load value for goomba enemy
 	a = M(PrimaryHardMode); // if primary hard mode flag not set,
 	if (z)
@@ -8256,7 +8303,7 @@ HandleGroupEnemies:
 	y = BuzzyBeetle; // for buzzy beetle
 
 PullID: // get second copy from stack
-	pla();
+	a = pla();
 
 SnglID: // save enemy id here
 	writeData(0x01, y);
@@ -8273,7 +8320,7 @@ SetYGp: // save y coordinate here
 	a = M(ScreenRight_X_Pos); // get pixel coordinate of right edge
 	writeData(0x03, a); // save here
 	y = 0x02; // load two enemies by default
-	pla(); // get first copy from stack
+	a = pla(); // get first copy from stack
 	a >>= 1; // check to see if d0 was set
 	if (!c)
 		goto CntGrp; // if not, use default value
@@ -8617,7 +8664,11 @@ RunNormalEnemies:
 	JSR(EnemyGfxHandler, 298);
 	JSR(GetEnemyBoundBox, 299);
 	JSR(EnemyToBGCollisionDet, 300);
-	JSR(EnemiesCollision, 301);
+#ifdef SMB_VERIFY_NATIVE
+	CALL_NATIVE(verifyNative(CODE_ENEMIES_COLLISION));
+#else
+	CALL_NATIVE(enemiesCollision()); // native, see SMBNative.cpp
+#endif
 	JSR(PlayerEnemyCollision, 302);
 	y = M(TimerControl); // if master timer control set, skip to last routine
 	if (!z)
@@ -8922,7 +8973,7 @@ SlowM: // if branched here, increment Y to slow horizontal movement
 
 SteadM: // get current horizontal speed
 	a = M(Enemy_X_Speed + x);
-	pha(); // save to stack
+	pha(a); // save to stack
 	if (!n)
 		goto AddHS; // if not moving or moving right, skip, leave Y alone
 	++y;
@@ -8933,7 +8984,7 @@ AddHS:
 	a += M(XSpeedAdderData + y); // add value here to slow enemy down if necessary
 	writeData(Enemy_X_Speed + x, a); // save as horizontal speed temporarily
 	JSR(MoveEnemyHorizontally, 328); // then do a sub to move horizontally
-	pla();
+	a = pla();
 	writeData(Enemy_X_Speed + x, a); // get old horizontal speed from stack and return to
 	goto Return; // original memory location, then leave
 
@@ -9084,7 +9135,7 @@ DecSeXM: // put secondary counter in A
 
 MoveWithXMCntrs:
 	a = M(XMoveSecondaryCounter + x); // save secondary counter to stack
-	pha();
+	pha(a);
 	y = 0x01; // set value here by default
 	a = M(XMovePrimaryCounter + x);
 	a &= (0b00000010); // if d1 of primary counter is
@@ -9101,7 +9152,7 @@ XMRight: // store as moving direction
 	writeData(Enemy_MovingDir + x, y);
 	JSR(MoveEnemyHorizontally, 334);
 	writeData(0x00, a); // save value obtained from sub here
-	pla(); // get secondary counter from stack
+	a = pla(); // get secondary counter from stack
 	writeData(XMoveSecondaryCounter + x, a); // and return to original place
 	goto Return;
 
@@ -9183,12 +9234,12 @@ ProcSwimmingB:
 		goto ChkForFloatdown; // branch if set
 	a = M(FrameCounter);
 	a &= (0b00000111); // get 3 LSB of frame counter
-	pha(); // and save it to the stack
+	pha(a); // and save it to the stack
 	a = M(BlooperMoveCounter + x); // get enemy's movement counter
 	a >>= 1; // check for d0 set
 	if (c)
 		goto SlowSwim; // branch if set
-	pla(); // pull 3 LSB of frame counter from the stack
+	a = pla(); // pull 3 LSB of frame counter from the stack
 	if (!z)
 		goto BSwimE; // branch to leave, execute code only every eighth frame
 	a = M(Enemy_Y_MoveForce + x);
@@ -9207,7 +9258,7 @@ BSwimE:
 //------------------------------------------------------------------------
 
 SlowSwim:
-	pla(); // pull 3 LSB of frame counter from the stack
+	a = pla(); // pull 3 LSB of frame counter from the stack
 	if (!z)
 		goto NoSSw; // branch to leave, execute code only every eighth frame
 	a = M(Enemy_Y_MoveForce + x);
@@ -9489,7 +9540,7 @@ SetVFbr: // store as Y coordinate here
 FirebarCollision:
 	JSR(DrawFirebar, 344); // run sub here to draw current tile of firebar
 	a = y; // return OAM data offset and save
-	pha(); // to the stack for now
+	pha(a); // to the stack for now
 	a = M(StarInvincibleTimer); // if star mario invincibility timer
 	a |= M(TimerControl); // or master timer controls set
 	if (!z)
@@ -9576,13 +9627,13 @@ SetSDir: // store movement direction here
 	writeData(Enemy_MovingDir, x);
 	x = 0x00;
 	a = M(0x00); // save value written to $00 to stack
-	pha();
+	pha(a);
 	JSR(InjurePlayer, 345); // perform sub to hurt or kill player
-	pla();
+	a = pla();
 	writeData(0x00, a); // get value of $00 from stack
 
 NoColFB: // get OAM data offset
-	pla();
+	a = pla();
 	c = 0; // add four to it and save
 	a += 0x04;
 	writeData(0x06, a);
@@ -9592,7 +9643,7 @@ NoColFB: // get OAM data offset
 //------------------------------------------------------------------------
 
 GetFirebarPosition:
-	pha(); // save high byte of spinstate to the stack
+	pha(a); // save high byte of spinstate to the stack
 	a &= (0b00001111); // mask out low nybble
 	compare(a, 0x09);
 	if (!c)
@@ -9610,8 +9661,8 @@ GetHAdder: // store result, modified or not, here
 	y = a; // to offset here and use as new offset
 	a = M(FirebarPosLookupTbl + y); // get data here and store as horizontal adder
 	writeData(0x01, a);
-	pla(); // pull whatever was in A from the stack
-	pha(); // save it again because we still need it
+	a = pla(); // pull whatever was in A from the stack
+	pha(a); // save it again because we still need it
 	c = 0;
 	a += 0x08; // add eight this time, to get vertical adder
 	a &= (0b00001111); // mask out high nybble
@@ -9631,7 +9682,7 @@ GetVAdder: // store result here
 	y = a;
 	a = M(FirebarPosLookupTbl + y); // get data here and store as vertica adder
 	writeData(0x02, a);
-	pla(); // pull out whatever was in A one last time
+	a = pla(); // pull out whatever was in A one last time
 	a >>= 1; // divide by eight or shift three to the right
 	a >>= 1;
 	a >>= 1;
@@ -10110,13 +10161,13 @@ CopyFToR: // move bowser's rear object position value to A
 	a = M(Enemy_MovingDir + x);
 	writeData(Enemy_MovingDir + y, a); // copy moving direction also
 	a = M(ObjectOffset); // save enemy object offset of front to stack
-	pha();
+	pha(a);
 	x = M(DuplicateObj_Offset); // put enemy object offset of rear as current
 	writeData(ObjectOffset, x);
 	a = Bowser; // set bowser's enemy identifier
 	writeData(Enemy_ID + x, a); // store in bowser's rear object
 	JSR(ProcessBowserHalf, 361); // do a sub here to process bowser's rear
-	pla();
+	a = pla();
 	writeData(ObjectOffset, a); // get original enemy object offset
 	x = a;
 	a = 0x00; // nullify bowser's front/rear graphics flag
@@ -10227,32 +10278,32 @@ DrawFlameLoop:
 	y = M(Enemy_SprDataOffset + x); // get OAM data offset
 	a = M(Enemy_OffscreenBits); // get enemy object offscreen bits
 	a >>= 1; // move d0 to carry and result to stack
-	pha();
+	pha(a);
 	if (!c)
 		goto M3FOfs; // branch if carry not set
 	a = 0xf8; // otherwise move sprite offscreen, this part likely
 	writeData(Sprite_Y_Position + 12 + y, a); // residual since flame is only made of three sprites
 
 M3FOfs: // get bits from stack
-	pla();
+	a = pla();
 	a >>= 1; // move d1 to carry and move bits back to stack
-	pha();
+	pha(a);
 	if (!c)
 		goto M2FOfs; // branch if carry not set again
 	a = 0xf8; // otherwise move third sprite offscreen
 	writeData(Sprite_Y_Position + 8 + y, a);
 
 M2FOfs: // get bits from stack again
-	pla();
+	a = pla();
 	a >>= 1; // move d2 to carry and move bits back to stack again
-	pha();
+	pha(a);
 	if (!c)
 		goto M1FOfs; // branch if carry not set yet again
 	a = 0xf8; // otherwise move second sprite offscreen
 	writeData(Sprite_Y_Position + 4 + y, a);
 
 M1FOfs: // get bits from stack one last time
-	pla();
+	a = pla();
 	a >>= 1; // move d3 to carry
 	if (!c)
 		goto ExFlmeD; // branch if carry not set one last time
@@ -10610,7 +10661,7 @@ ChkOtherForFall:
 
 ChkToMoveBalPlat:
 	a = M(Enemy_Y_Position + x); // save vertical position to stack
-	pha();
+	pha(a);
 	a = M(PlatformCollisionFlag + x); // get collision flag
 	if (!n)
 		goto ColFlg; // branch if collision
@@ -10649,7 +10700,7 @@ PlatDn: // do a sub to move downwards
 
 DoOtherPlatform:
 	y = M(Enemy_State + x); // get offset of other platform
-	pla(); // get old vertical coordinate from stack
+	a = pla(); // get old vertical coordinate from stack
 	c = 1;
 	a -= M(Enemy_Y_Position + x); // get difference of old vs. new coordinate
 	c = 0;
@@ -10672,8 +10723,8 @@ DrawEraseRope:
 	if (c)
 		goto ExitRp; // and skip this, branch to leave
 	a = M(Enemy_Y_Speed + y);
-	pha(); // save two copies of vertical speed to stack
-	pha();
+	pha(a); // save two copies of vertical speed to stack
+	pha(a);
 	JSR(SetupPlatformRope, 378); // do a sub to figure out where to put new bg tiles
 	a = M(0x01); // write name table address to vram buffer
 	writeData(VRAM_Buffer1 + x, a); // first the high byte, then the low
@@ -10698,7 +10749,7 @@ EraseR1: // put blank tiles in vram buffer
 OtherRope:
 	a = M(Enemy_State + y); // get offset of other platform from state
 	y = a; // use as Y here
-	pla(); // pull second copy of vertical speed from stack
+	a = pla(); // pull second copy of vertical speed from stack
 	a ^= 0xff; // invert bits to reverse speed
 	JSR(SetupPlatformRope, 379); // do sub again to figure out where to put bg tiles  
 	a = M(0x01); // write name table address to vram buffer
@@ -10707,7 +10758,7 @@ OtherRope:
 	writeData(VRAM_Buffer1 + 6 + x, a);
 	a = 0x02;
 	writeData(VRAM_Buffer1 + 7 + x, a); // set length again for 2 bytes
-	pla(); // pull first copy of vertical speed from stack
+	a = pla(); // pull first copy of vertical speed from stack
 	if (!n)
 		goto EraseR2; // if moving upwards (note inversion earlier), skip this
 	a = 0xa2;
@@ -10736,7 +10787,7 @@ ExitRp: // get enemy object buffer offset and leave
 //------------------------------------------------------------------------
 
 SetupPlatformRope:
-	pha(); // save second/third copy to stack
+	pha(a); // save second/third copy to stack
 	a = M(Enemy_X_Position + y); // get horizontal coordinate
 	c = 0;
 	a += 0x08; // add eight pixels
@@ -10747,18 +10798,18 @@ SetupPlatformRope:
 	a += 0x10; // otherwise add sixteen more pixels
 
 GetLRp: // save modified horizontal coordinate to stack
-	pha();
+	pha(a);
 	a = M(Enemy_PageLoc + y);
 	a += 0x00; // add carry to page location
 	writeData(0x02, a); // and save here
-	pla(); // pull modified horizontal coordinate
+	a = pla(); // pull modified horizontal coordinate
 	a &= (0b11110000); // from the stack, mask out low nybble
 	a >>= 1; // and shift three bits to the right
 	a >>= 1;
 	a >>= 1;
 	writeData(0x00, a); // store result here as part of name table low byte
 	x = M(Enemy_Y_Position + y); // get vertical coordinate
-	pla(); // get second/third copy of vertical speed from stack
+	a = pla(); // get second/third copy of vertical speed from stack
 	if (!n)
 		goto GetHRp; // skip this part if moving downwards or not at all
 	a = x;
@@ -10771,7 +10822,7 @@ GetHRp: // move vertical coordinate to A
 	x = M(VRAM_Buffer1_Offset); // get vram buffer offset
 	a <<= 1;
 	a.rol(); // rotate d7 to d0 and d6 into carry
-	pha(); // save modified vertical coordinate to stack
+	pha(a); // save modified vertical coordinate to stack
 	a.rol(); // rotate carry to d0, thus d7 and d6 are at 2 LSB
 	a &= (0b00000011); // mask out all bits but d7 and d6, then set
 	a |= (0b00100000); // d5 to get appropriate high byte of name table
@@ -10782,7 +10833,7 @@ GetHRp: // move vertical coordinate to A
 	a <<= 1; // shift twice to the left and save with the
 	a |= M(0x01); // rest of the bits of the high byte, to get
 	writeData(0x01, a); // the proper name table and the right place on it
-	pla(); // get modified vertical coordinate from stack
+	a = pla(); // get modified vertical coordinate from stack
 	a &= (0b11100000); // mask out low nybble and LSB of high nybble
 	c = 0;
 	a += M(0x00); // add to horizontal part saved here
@@ -10823,9 +10874,9 @@ StopPlatforms:
 
 PlatformFall:
 	a = y; // save offset for other platform to stack
-	pha();
+	pha(a);
 	JSR(MoveFallingPlatform, 383); // make current platform fall
-	pla();
+	a = pla();
 	x = a; // pull offset from stack and save to X
 	JSR(MoveFallingPlatform, 384); // make other platform fall
 	x = M(ObjectOffset);
@@ -11064,7 +11115,7 @@ FireballEnemyCollision:
 FireballEnemyCDLoop:
 	writeData(0x01, x); // store enemy object offset here
 	a = y;
-	pha(); // push fireball offset to the stack
+	pha(a); // push fireball offset to the stack
 	a = M(Enemy_State + x);
 	a &= (0b00100000); // check to see if d5 is set in enemy state
 	if (!z)
@@ -11109,7 +11160,7 @@ NotGoomba: // if any masked offscreen bits set,
 	JSR(HandleEnemyFBallCol, 401); // jump to handle fireball to enemy collision
 
 NoFToECol: // pull fireball offset from stack
-	pla();
+	a = pla();
 	y = a; // put it in Y
 	x = M(0x01); // get enemy object offset
 	--x; // decrement it
@@ -11553,9 +11604,9 @@ EnemyStompedPts:
 	a = M(StompedEnemyPtsData + y); // load points data using offset in Y
 	JSR(SetupFloateyNumber, 417); // run sub to set floatey number controls
 	a = M(Enemy_MovingDir + x);
-	pha(); // save enemy movement direction to stack
+	pha(a); // save enemy movement direction to stack
 	JSR(SetStun, 418); // run sub to kill enemy
-	pla();
+	a = pla();
 	writeData(Enemy_MovingDir + x, a); // return enemy movement direction from stack
 	a = (0b00100000);
 	writeData(Enemy_State + x, a); // set d5 in enemy state
@@ -11671,7 +11722,7 @@ EnemiesCollision:
 ECLoop: // save enemy object buffer offset for second enemy here
 	writeData(0x01, x);
 	a = y; // save first enemy's bounding box offset to stack
-	pha();
+	pha(a);
 	a = M(Enemy_Flag + x); // check enemy object enable flag
 	if (z)
 		goto ReadyNextEnemy; // branch if flag not set
@@ -11722,7 +11773,7 @@ NoEnemyCollision:
 	writeData(Enemy_CollisionBits + y, a); // then move onto next enemy slot
 
 ReadyNextEnemy:
-	pla(); // get first enemy's bounding box offset from the stack
+	a = pla(); // get first enemy's bounding box offset from the stack
 	y = a; // use as Y again
 	x = M(0x01); // get and decrement second enemy's object buffer offset
 	--x;
@@ -11866,9 +11917,9 @@ ChkForPlayerC_LargeP:
 	a = M(Enemy_Y_Position + x); // store vertical coordinate in
 	writeData(0x00, a); // temp variable for now
 	a = x; // send offset we're on to the stack
-	pha();
+	pha(a);
 	JSR(PlayerCollisionCore, 439); // do player-to-platform collision detection
-	pla(); // retrieve offset from the stack
+	a = pla(); // retrieve offset from the stack
 	x = a;
 	if (!c)
 		goto ExLPC; // if no collision, branch to leave
@@ -12181,10 +12232,10 @@ DoFootCheck:
 	JSR(CheckForCoinMTiles, 450); // check to see if player touched coin with their left foot
 	if (c)
 		goto AwardTouchedCoin; // if so, branch to some other part of code
-	pha(); // save bottom left metatile to stack
+	pha(a); // save bottom left metatile to stack
 	JSR(BlockBufferColli_Feet, 451); // do player-to-bg collision detection on bottom right of player
 	writeData(0x00, a); // save bottom right metatile here
-	pla();
+	a = pla();
 	writeData(0x01, a); // pull bottom left metatile and save here
 	if (!z)
 		goto ChkFootMTile; // if anything here, skip this part
@@ -13275,7 +13326,7 @@ BoundingBoxCore:
 	a = x; // multiply offset by four and save to stack
 	a <<= 1;
 	a <<= 1;
-	pha();
+	pha(a);
 	y = a; // use as offset for Y, X is left alone
 	a = M(SprObj_BoundBoxCtrl + x); // load value here to be used as offset for X
 	a <<= 1; // multiply that by four and use as X
@@ -13299,7 +13350,7 @@ BoundingBoxCore:
 	c = 0;
 	a += M(BoundBoxCtrlData + 2 + x); // add the fourth number to the relative vertical coordinate
 	writeData(BoundingBox_LR_Corner + y, a); // and store
-	pla(); // get original offset loaded into $00 * y from stack
+	a = pla(); // get original offset loaded into $00 * y from stack
 	y = a; // use as Y
 	x = M(0x00); // get original offset and use as X again
 	goto Return;
@@ -13443,12 +13494,12 @@ CollisionFound:
 //------------------------------------------------------------------------
 
 BlockBufferChk_Enemy:
-	pha(); // save contents of A to stack
+	pha(a); // save contents of A to stack
 	a = x;
 	c = 0; // add 1 to X to run sub with enemy offset in mind
 	a += 0x01;
 	x = a;
-	pla(); // pull A from stack and jump elsewhere
+	a = pla(); // pull A from stack and jump elsewhere
 	goto BBChk_E;
 
 ResidualMiscObjectCode:
@@ -13490,7 +13541,15 @@ Skip_9:
 	x = 0x00; // set offset for player object
 
 BlockBufferCollision:
-	pha(); // save contents of A to stack
+#ifdef SMB_VERIFY_NATIVE
+	CALL_NATIVE(verifyNative(CODE_BLOCK_BUFFER_COLLISION));
+#else
+	CALL_NATIVE(blockBufferCollision()); // native, see SMBNative.cpp
+#endif
+	goto Return;
+
+BlockBufferCollisionDecompiled:
+	pha(a); // save contents of A to stack
 	writeData(0x04, y); // save contents of Y here
 	a = M(BlockBuffer_X_Adder + y); // add horizontal coordinate
 	c = 0; // of object to value obtained using Y as offset
@@ -13518,7 +13577,7 @@ BlockBufferCollision:
 	a = M(W(0x06) + y); // check current content of block buffer
 	writeData(0x03, a); // and store here
 	y = M(0x04); // get old contents of Y again
-	pla(); // pull A from stack
+	a = pla(); // pull A from stack
 	if (!z)
 		goto RetXC; // if A = 1, branch
 	a = M(SprObject_Y_Position + x); // if A = 0, load vertical coordinate
@@ -13803,50 +13862,50 @@ SetPlatformTilenum:
 	--x;
 	y = M(Enemy_SprDataOffset + x); // get OAM data offset
 	a <<= 1; // rotate d7 into carry, save remaining
-	pha(); // bits to the stack
+	pha(a); // bits to the stack
 	if (!c)
 		goto SChk2;
 	a = 0xf8; // if d7 was set, move first sprite offscreen
 	writeData(Sprite_Y_Position + y, a);
 
 SChk2: // get bits from stack
-	pla();
+	a = pla();
 	a <<= 1; // rotate d6 into carry
-	pha(); // save to stack
+	pha(a); // save to stack
 	if (!c)
 		goto SChk3;
 	a = 0xf8; // if d6 was set, move second sprite offscreen
 	writeData(Sprite_Y_Position + 4 + y, a);
 
 SChk3: // get bits from stack
-	pla();
+	a = pla();
 	a <<= 1; // rotate d5 into carry
-	pha(); // save to stack
+	pha(a); // save to stack
 	if (!c)
 		goto SChk4;
 	a = 0xf8; // if d5 was set, move third sprite offscreen
 	writeData(Sprite_Y_Position + 8 + y, a);
 
 SChk4: // get bits from stack
-	pla();
+	a = pla();
 	a <<= 1; // rotate d4 into carry
-	pha(); // save to stack
+	pha(a); // save to stack
 	if (!c)
 		goto SChk5;
 	a = 0xf8; // if d4 was set, move fourth sprite offscreen
 	writeData(Sprite_Y_Position + 12 + y, a);
 
 SChk5: // get bits from stack
-	pla();
+	a = pla();
 	a <<= 1; // rotate d3 into carry
-	pha(); // save to stack
+	pha(a); // save to stack
 	if (!c)
 		goto SChk6;
 	a = 0xf8; // if d3 was set, move fifth sprite offscreen
 	writeData(Sprite_Y_Position + 16 + y, a);
 
 SChk6: // get bits from stack
-	pla();
+	a = pla();
 	a <<= 1; // rotate d2 into carry
 	if (!c)
 		goto SLChk; // save to stack
@@ -13935,7 +13994,7 @@ DrawPowerUp:
 	a |= M(Enemy_SprAttrib + 5); // add background priority bit if set
 	writeData(0x04, a); // store attributes here
 	a = x;
-	pha(); // save power-up type to the stack
+	pha(a); // save power-up type to the stack
 	a <<= 1;
 	a <<= 1; // multiply by four to get proper offset
 	x = a; // use as X
@@ -13952,7 +14011,7 @@ PUpDrawLoop:
 	if (!n)
 		goto PUpDrawLoop; // branch until two rows are drawn
 	y = M(Enemy_SprDataOffset + 5); // get sprite data offset again
-	pla(); // pull saved power-up type from the stack
+	a = pla(); // pull saved power-up type from the stack
 	if (z)
 		goto PUpOfs; // if regular mushroom, branch, do not change colors or flip
 	compare(a, 0x03);
@@ -14362,16 +14421,16 @@ CheckForVerticalFlip:
 
 FlipEnemyVertically:
 	a = M(Sprite_Tilenumber + x); // load first or second row tiles
-	pha(); // and save tiles to the stack
+	pha(a); // and save tiles to the stack
 	a = M(Sprite_Tilenumber + 4 + x);
-	pha();
+	pha(a);
 	a = M(Sprite_Tilenumber + 16 + y); // exchange third row tiles
 	writeData(Sprite_Tilenumber + x, a); // with first or second row tiles
 	a = M(Sprite_Tilenumber + 20 + y);
 	writeData(Sprite_Tilenumber + 4 + x, a);
-	pla(); // pull first or second row tiles from stack
+	a = pla(); // pull first or second row tiles from stack
 	writeData(Sprite_Tilenumber + 20 + y, a); // and save in third row
-	pla();
+	a = pla();
 	writeData(Sprite_Tilenumber + 16 + y, a);
 
 CheckForESymmetry:
@@ -14494,42 +14553,42 @@ SprObjectOffscrChk:
 	a >>= 1;
 	a >>= 1; // shift three times to the right
 	a >>= 1; // which puts d2 into carry
-	pha(); // save to stack
+	pha(a); // save to stack
 	if (!c)
 		goto LcChk; // branch if not set
 	a = 0x04; // set for right column sprites
 	JSR(MoveESprColOffscreen, 514); // and move them offscreen
 
 LcChk: // get from stack
-	pla();
+	a = pla();
 	a >>= 1; // move d3 to carry
-	pha(); // save to stack
+	pha(a); // save to stack
 	if (!c)
 		goto Row3C; // branch if not set
 	a = 0x00; // set for left column sprites,
 	JSR(MoveESprColOffscreen, 515); // move them offscreen
 
 Row3C: // get from stack again
-	pla();
+	a = pla();
 	a >>= 1; // move d5 to carry this time
 	a >>= 1;
-	pha(); // save to stack again
+	pha(a); // save to stack again
 	if (!c)
 		goto Row23C; // branch if carry not set
 	a = 0x10; // set for third row of sprites
 	JSR(MoveESprRowOffscreen, 516); // and move them offscreen
 
 Row23C: // get from stack
-	pla();
+	a = pla();
 	a >>= 1; // move d6 into carry
-	pha(); // save to stack
+	pha(a); // save to stack
 	if (!c)
 		goto AllRowC;
 	a = 0x08; // set for second and third rows
 	JSR(MoveESprRowOffscreen, 517); // move them offscreen
 
 AllRowC: // get from stack once more
-	pla();
+	a = pla();
 	a >>= 1; // move d7 into carry
 	if (!c)
 		goto ExEGHandler;
@@ -14633,7 +14692,7 @@ SetBFlip: // put block object offset back in X
 
 BlkOffscr: // get offscreen bits for block object
 	a = M(Block_OffscreenBits);
-	pha(); // save to stack
+	pha(a); // save to stack
 	a &= (0b00000100); // check to see if d2 in offscreen bits are set
 	if (z)
 		goto PullOfsB; // if not set, branch, otherwise move sprites offscreen
@@ -14642,7 +14701,7 @@ BlkOffscr: // get offscreen bits for block object
 	writeData(Sprite_Y_Position + 12 + y, a);
 
 PullOfsB: // pull offscreen bits from stack
-	pla();
+	a = pla();
 
 ChkLeftCo: // check to see if d3 in offscreen bits are set
 	a &= (0b00001000);
@@ -14747,11 +14806,11 @@ DrawFirebar:
 	a = M(FrameCounter); // get frame counter
 	a >>= 1; // divide by four
 	a >>= 1;
-	pha(); // save result to stack
+	pha(a); // save result to stack
 	a &= 0x01; // mask out all but last bit
 	a ^= 0x64; // set either tile $64 or $65 as fireball tile
 	writeData(Sprite_Tilenumber + y, a); // thus tile changes every four frames
-	pla(); // get from stack
+	a = pla(); // get from stack
 	a >>= 1; // divide by four again
 	a >>= 1;
 	a = 0x02; // load value $02 to set palette in attrib byte
@@ -14842,7 +14901,7 @@ DrawSmallPlatform:
 	writeData(Sprite_X_Position + 20 + y, a);
 	a = M(Enemy_Y_Position + x); // get vertical coordinate
 	x = a;
-	pha(); // save to stack
+	pha(a); // save to stack
 	compare(x, 0x20); // if vertical coordinate below status bar,
 	if (c)
 		goto TopSP; // do not mess with it
@@ -14850,7 +14909,7 @@ DrawSmallPlatform:
 
 TopSP: // dump vertical coordinate into Y coordinates
 	JSR(DumpThreeSpr, 531);
-	pla(); // pull from stack
+	a = pla(); // pull from stack
 	c = 0;
 	a += 0x80; // add 128 pixels
 	x = a;
@@ -14864,7 +14923,7 @@ BotSP: // dump vertical coordinate + 128 pixels
 	writeData(Sprite_Y_Position + 16 + y, a); // into Y coordinates
 	writeData(Sprite_Y_Position + 20 + y, a);
 	a = M(Enemy_OffscreenBits); // get offscreen bits
-	pha(); // save to stack
+	pha(a); // save to stack
 	a &= (0b00001000); // check d3
 	if (z)
 		goto SOfs;
@@ -14873,8 +14932,8 @@ BotSP: // dump vertical coordinate + 128 pixels
 	writeData(Sprite_Y_Position + 12 + y, a);
 
 SOfs: // move out and back into stack
-	pla();
-	pha();
+	a = pla();
+	pha(a);
 	a &= (0b00000100); // check d2
 	if (z)
 		goto SOfs2;
@@ -14883,7 +14942,7 @@ SOfs: // move out and back into stack
 	writeData(Sprite_Y_Position + 16 + y, a);
 
 SOfs2: // get from stack
-	pla();
+	a = pla();
 	a &= (0b00000010); // check d1
 	if (z)
 		goto ExSPl;
@@ -15192,7 +15251,7 @@ ThreeFrameExtent:
 AnimationControl:
 	writeData(0x00, a); // store upper extent here
 	JSR(GetCurrentAnimOffset, 546); // get proper offset to graphics table
-	pha(); // save offset to stack
+	pha(a); // save offset to stack
 	a = M(PlayerAnimTimer); // load animation frame timer
 	if (!z)
 		goto ExAnimC; // branch if not expired
@@ -15210,7 +15269,7 @@ SetAnimC: // store as new animation frame control
 	writeData(PlayerAnimCtrl, a);
 
 ExAnimC: // get offset to graphics table from stack and leave
-	pla();
+	a = pla();
 	goto Return;
 
 //------------------------------------------------------------------------
@@ -15435,7 +15494,7 @@ SetOffscrBitsOffset:
 
 GetOffScreenBitsSet:
 	a = y; // save offscreen bits offset to stack for now
-	pha();
+	pha(a);
 	JSR(RunOffscrBitsSubs, 556);
 	a <<= 1; // move low nybble to high nybble
 	a <<= 1;
@@ -15443,7 +15502,7 @@ GetOffScreenBitsSet:
 	a <<= 1;
 	a |= M(0x00); // mask together with previously saved low nybble
 	writeData(0x00, a); // store both here
-	pla(); // get offscreen bits offset from stack
+	a = pla(); // get offscreen bits offset from stack
 	y = a;
 	a = M(0x00); // get value here and store elsewhere
 	writeData(SprObject_OffscrBits + y, a);
@@ -16787,6 +16846,9 @@ LoadWaterEventMusEnvData:
 Return:
 	switch (popReturnIndex())
 	{
+	case NATIVE_RETURN_INDEX:
+		STORE_REGISTERS();
+		return;
 	case 0:
 		goto Return_0;
 	case 1:
@@ -16797,8 +16859,6 @@ Return:
 		goto Return_3;
 	case 4:
 		goto Return_4;
-	case 5:
-		goto Return_5;
 	case 6:
 		goto Return_6;
 	case 7:
@@ -16807,10 +16867,6 @@ Return:
 		goto Return_8;
 	case 9:
 		goto Return_9;
-	case 10:
-		goto Return_10;
-	case 11:
-		goto Return_11;
 	case 12:
 		goto Return_12;
 	case 13:
@@ -17389,8 +17445,6 @@ Return:
 		goto Return_299;
 	case 300:
 		goto Return_300;
-	case 301:
-		goto Return_301;
 	case 302:
 		goto Return_302;
 	case 303:
@@ -20,6 +20,41 @@
  */
 #define W(addr) getMemoryWord(addr)
 
+/**
+ * Modes for SMBEngine::code() that run a single decompiled subroutine, so
+ * native code can call it through SMBEngine::callDecompiled().
+ */
+#define CODE_PROC_ENEMY_COLLISIONS   2
+#define CODE_ENEMIES_COLLISION       3
+#define CODE_PROCESS_AREA_DATA       4
+#define CODE_AREA_PARSER_CORE        5
+#define CODE_INITIALIZE_AREA         6
+#define CODE_BLOCK_BUFFER_COLLISION  7
+#define CODE_MOVE_SPRITES_OFFSCREEN  8
+#define CODE_SPRITE_SHUFFLER         9
+#define CODE_UPDATE_SCREEN           10
+#define CODE_RENDER_AREA_GRAPHICS    11
+#define CODE_RENDER_ATTRIBUTE_TABLES 12
+#define CODE_CHECK_FOR_SOLID_MTILES  13
+
+/**
+ * Return index that makes the decompiled code return to its native caller.
+ */
+#define NATIVE_RETURN_INDEX 0xffff
+
+/**
+ * Write the registers that code() keeps in local variables back to the engine
+ * (registerA, registerX and registerY), or read them again from it.
+ */
+#define STORE_REGISTERS() registerA = a; registerX = x; registerY = y
+#define LOAD_REGISTERS() a.set(registerA); x.set(registerX); y.set(registerY)
+
+/**
+ * Call native code from code(). Native code uses the engine's registers, so
+ * they are brought up to date before the call and read again after it.
+ */
+#define CALL_NATIVE(call) do { STORE_REGISTERS(); call; LOAD_REGISTERS(); } while (0)
+
 /**
  * Call a subroutine stored in a goto label.
  */
@@ -1,101 +1,223 @@
 #include <cstring>
-
-#include "../Configuration.hpp"
+#include <type_traits>
 
 #include "../Emulation/APU.hpp"
 #include "../Emulation/Controller.hpp"
 #include "../Emulation/PPU.hpp"
+#include "../Util/RomImage.hpp"
 
 #include "SMBEngine.hpp"
 
 #include "../tonccpy.h"
 
-#define DATA_STORAGE_OFFSET 0x8000 // Starting address for storing constant data
+#define DATA_STORAGE_OFFSET 0x8000 // Starting address of constant data
+
+// Everything an engine owns except the optional audio sample buffer, APU channels included
+static_assert(sizeof(SMBEngine) <= 8192, "SMBEngine instances should stay under 8 KB for batch simulation");
 
 //---------------------------------------------------------------------
-// Public interface
+// SMBEngineState
 //---------------------------------------------------------------------
 
-SMBEngine::SMBEngine(uint8_t* romImage) :
-    a(*this, &registerA),
-    x(*this, &registerX),
-    y(*this, &registerY),
-    s(*this, &registerS)
+SMBEngineState::SMBEngineState(SMBEngine& engine)
 {
-    apu = new APU();
-    ppu = new PPU(*this);
+    ppu = new PPU(engine);
     controller1 = new Controller();
     controller2 = new Controller();
-
-    // CHR Location in ROM: Header (16 bytes) + 2 PRG pages (16k each)
-    chr = (romImage + 16 + (16384 * 2));
-
-    returnIndexStackTop = 0;
 }
 
-SMBEngine::~SMBEngine()
+SMBEngineState::~SMBEngineState()
 {
-    delete apu;
     delete ppu;
     delete controller1;
     delete controller2;
 }
 
+bool SMBEngineState::read(FILE* file)
+{
+    uint8_t flags[7];
+    int32_t stackTop;
+    if (fread(flags, sizeof(flags), 1, file) != 1 ||
+        fread(ram, sizeof(ram), 1, file) != 1 ||
+        fread(returnIndexStack, sizeof(returnIndexStack), 1, file) != 1 ||
+        fread(&stackTop, sizeof(stackTop), 1, file) != 1 ||
+        !ppu->readState(file) ||
+        fread(controller1, sizeof(Controller), 1, file) != 1 ||
+        fread(controller2, sizeof(Controller), 1, file) != 1)
+    {
+        return false;
+    }
+
+    c = flags[0] != 0;
+    z = flags[1] != 0;
+    n = flags[2] != 0;
+    registerA = flags[3];
+    registerX = flags[4];
+    registerY = flags[5];
+    registerS = flags[6];
+    returnIndexStackTop = stackTop;
+    return true;
+}
+
+bool SMBEngineState::write(FILE* file) const
+{
+    // Controllers hold only plain values, so they are stored as they are in memory
+    //
+    static_assert(std::is_trivially_copyable<Controller>::value, "Controller must be trivially copyable");
+    uint8_t flags[] = { c, z, n, registerA, registerX, registerY, registerS };
+    int32_t stackTop = returnIndexStackTop;
+    return fwrite(flags, sizeof(flags), 1, file) == 1 &&
+        fwrite(ram, sizeof(ram), 1, file) == 1 &&
+        fwrite(returnIndexStack, sizeof(returnIndexStack), 1, file) == 1 &&
+        fwrite(&stackTop, sizeof(stackTop), 1, file) == 1 &&
+        ppu->writeState(file) &&
+        fwrite(controller1, sizeof(Controller), 1, file) == 1 &&
+        fwrite(controller2, sizeof(Controller), 1, file) == 1;
+}
+
+//---------------------------------------------------------------------
+// Public interface
+//---------------------------------------------------------------------
+
+const SMBDataPointers SMBEngine::dataPointers;
+
+SMBEngine::SMBEngine(const RomImage& rom, const RuntimeConfig& config) :
+    ppu(*this),
+    apu(config),
+    config(config)
+#ifdef SMB_VERIFY_NATIVE
+    , nativeCallState(*this)
+#endif
+{
+    audioSuspended = false;
+#ifdef SMB_VERIFY_NATIVE
+    nativeCallRecording = nullptr;
+    nativeMismatches = 0;
+#endif
+
+    chr = rom.getCHR();
+
+    // Start from the same power-on state every time, wherever the engine was allocated
+    //
+    clearState();
+}
+
 void SMBEngine::audioCallback(uint8_t* stream, int length)
 {
-    apu->output(stream, length);
+    apu.output(stream, length);
+}
+
+APU& SMBEngine::getAPU()
+{
+    return apu;
+}
+
+PPU& SMBEngine::getPPU()
+{
+    return ppu;
 }
 
 Controller& SMBEngine::getController1()
 {
-    return *controller1;
+    return controller1;
 }
 
 Controller& SMBEngine::getController2()
 {
-    return *controller2;
+    return controller2;
 }
 
 /*void SMBEngine::render(uint32_t* buffer)
 {
-    ppu->render(buffer);
+    ppu.render(buffer);
 }*/
 
 void SMBEngine::renderBGColor(uint32_t* buffer)
 {
-    ppu->renderBGColor(buffer);
+    ppu.renderBGColor(buffer);
 }
 
 void SMBEngine::renderBGObj(uint32_t* buffer)
 {
-    ppu->renderBGObj(buffer);
+    ppu.renderBGObj(buffer);
 }
 
 void SMBEngine::renderBGNT(uint32_t* buffer)
 {
-    ppu->renderBGNT(buffer);
+    ppu.renderBGNT(buffer);
 }
 
 void SMBEngine::renderFGObj(uint32_t* buffer)
 {
-    ppu->renderFGObj(buffer);
+    ppu.renderFGObj(buffer);
+}
+
+void SMBEngine::loadState(const SMBEngineState& state)
+{
+    c = state.c;
+    z = state.z;
+    n = state.n;
+    registerA = state.registerA;
+    registerX = state.registerX;
+    registerY = state.registerY;
+    registerS = state.registerS;
+    memcpy(ram, state.ram, sizeof(ram));
+    memcpy(returnIndexStack, state.returnIndexStack, sizeof(returnIndexStack));
+    returnIndexStackTop = state.returnIndexStackTop;
+    ppu.copyState(*state.ppu);
+    controller1 = *state.controller1;
+    controller2 = *state.controller2;
 }
 
 void SMBEngine::reset()
 {
+    // The game's reset routine leaves parts of RAM and the PPU as they were,
+    // so clear everything first to make a reset equivalent to a new engine
+    //
+    clearState();
+
     // Run the decompiled code for initialization
     code(0);
 }
 
+void SMBEngine::saveState(SMBEngineState& state) const
+{
+    state.c = c;
+    state.z = z;
+    state.n = n;
+    state.registerA = registerA;
+    state.registerX = registerX;
+    state.registerY = registerY;
+    state.registerS = registerS;
+    memcpy(state.ram, ram, sizeof(ram));
+    memcpy(state.returnIndexStack, returnIndexStack, sizeof(returnIndexStack));
+    state.returnIndexStackTop = returnIndexStackTop;
+    state.ppu->copyState(ppu);
+    *state.controller1 = controller1;
+    *state.controller2 = controller2;
+}
+
+void SMBEngine::reconfigure(const RuntimeConfig& config)
+{
+    this->config = config;
+    this->config.computeDerivedValues();
+    apu.reconfigure(config);
+}
+
+void SMBEngine::setAudioSuspended(bool suspended)
+{
+    audioSuspended = suspended;
+}
+
 void SMBEngine::update()
 {
     // Run the decompiled code for the NMI handler
     code(1);
 
     // Update the APU
-    if (Configuration::getAudioEnabled())
+    if (config.audioEnabled && !audioSuspended)
     {
-        apu->stepFrame();
+        apu.stepFrame();
     }
 }
 
@@ -103,6 +225,23 @@ void SMBEngine::update()
 // Private methods
 //---------------------------------------------------------------------
 
+void SMBEngine::clearState()
+{
+    memset(ram, 0, sizeof(ram));
+    c = false;
+    z = false;
+    n = false;
+    registerA = 0;
+    registerX = 0;
+    registerY = 0;
+    registerS = 0;
+    memset(returnIndexStack, 0, sizeof(returnIndexStack));
+    returnIndexStackTop = 0;
+    ppu.reset();
+    controller1 = Controller();
+    controller2 = Controller();
+}
+
 void SMBEngine::compare(uint8_t value1, uint8_t value2)
 {
     uint8_t result = value1 - value2;
@@ -110,61 +249,32 @@ void SMBEngine::compare(uint8_t value1, uint8_t value2)
     setZN(result);
 }
 
-void SMBEngine::bit(uint8_t value)
+void SMBEngine::bit(uint8_t accumulator, uint8_t value)
 {
     n = (value & (1 << 7)) != 0;
-    z = (registerA & value) == 0;
+    z = (accumulator & value) == 0;
 }
 
-uint8_t* SMBEngine::getCHR()
+const uint8_t* SMBEngine::getCHR() const
 {
     return chr;
 }
 
-uint8_t* SMBEngine::getDataPointer(uint16_t address)
-{
-    // Constant data
-    if( address >= DATA_STORAGE_OFFSET )
-    {
-        return dataStorage + (address - DATA_STORAGE_OFFSET);
-    }
-    // RAM and Mirrors
-    else if( address < 0x2000 )
-    {
-        return ram + (address & 0x7ff);
-    }
-
-    return nullptr;
-}
-
-MemoryAccess SMBEngine::getMemory(uint16_t address)
-{
-    uint8_t* dataPointer = getDataPointer(address);
-    if( dataPointer != nullptr )
-    {
-        return MemoryAccess(*this, dataPointer);
-    }
-    else
-    {
-        return MemoryAccess(*this, readData(address));
-    }
-}
-
 uint16_t SMBEngine::getMemoryWord(uint8_t address)
 {
     return (uint16_t)readData(address) + ((uint16_t)(readData(address + 1)) << 8);
 }
 
-void SMBEngine::pha()
+void SMBEngine::pha(uint8_t accumulator)
 {
-    writeData(0x100 | (uint16_t)registerS, registerA);
+    writeData(0x100 | (uint16_t)registerS, accumulator);
     registerS--;
 }
 
-void SMBEngine::pla()
+uint8_t SMBEngine::pla()
 {
     registerS++;
-    a = readData(0x100 | (uint16_t)registerS);
+    return readData(0x100 | (uint16_t)registerS);
 }
 
 int SMBEngine::popReturnIndex()
@@ -182,7 +292,7 @@ uint8_t SMBEngine::readData(uint16_t address)
     // Constant data
     if( address >= DATA_STORAGE_OFFSET )
     {
-        return dataStorage[address - DATA_STORAGE_OFFSET];
+        return smbConstantData[address - DATA_STORAGE_OFFSET];
     }
     // RAM and Mirrors
     else if( address < 0x2000 )
@@ -192,7 +302,7 @@ uint8_t SMBEngine::readData(uint16_t address)
     // PPU Registers and Mirrors
     else if( address < 0x4000 )
     {
-        return ppu->readRegister(0x2000 + (address & 0x7));
+        return ppu.readRegister(0x2000 + (address & 0x7));
     }
     // IO registers
     else if( address < 0x4020 )
@@ -200,9 +310,9 @@ uint8_t SMBEngine::readData(uint16_t address)
         switch (address)
         {
         case 0x4016:
-            return controller1->readByte();
+            return controller1.readByte();
         case 0x4017:
-            return controller2->readByte();
+            return controller2.readByte();
         }
     }
 
@@ -225,7 +335,7 @@ void SMBEngine::writeData(uint16_t address, uint8_t value)
     // PPU Registers and Mirrors
     else if( address < 0x4000 )
     {
-        ppu->writeRegister(0x2000 + (address & 0x7), value);
+        ppu.writeRegister(0x2000 + (address & 0x7), value);
     }
     // IO registers
     else if( address < 0x4020 )
@@ -233,23 +343,18 @@ void SMBEngine::writeData(uint16_t address, uint8_t value)
         switch( address )
         {
         case 0x4014:
-            ppu->writeDMA(value);
+            ppu.writeDMA(value);
             break;
         case 0x4016:
-            controller1->writeByte(value);
-            controller2->writeByte(value);
+            controller1.writeByte(value);
+            controller2.writeByte(value);
             break;
         default:
-            apu->writeRegister(address, value);
+            if (!audioSuspended)
+            {
+                apu.writeRegister(address, value);
+            }
             break;
         }
     }
 }
-
-void SMBEngine::writeData(uint16_t address, const uint8_t* data, size_t length)
-{
-    address -= DATA_STORAGE_OFFSET;
-
-    //memcpy(dataStorage + (std::ptrdiff_t)address, data, length);
-    memcpy(dataStorage + (int)address, data, length);
-}
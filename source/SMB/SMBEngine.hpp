@@ -3,38 +3,138 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <cstdio>
+#include <iosfwd>
 
+#include "../Configuration.hpp"
+#include "../Emulation/APU.hpp"
+#include "../Emulation/Controller.hpp"
 #include "../Emulation/MemoryAccess.hpp"
+#include "../Emulation/PPU.hpp"
+#include "../Emulation/Register.hpp"
 
 #include "SMBDataPointers.hpp"
 
-class APU;
-class Controller;
-class PPU;
+#define SMBENGINE_ALIGNMENT 64 // Engines start on a cache line (32 bytes on the 3DS, 64 on most desktops)
+
+/**
+ * Constant data that was present in the SMB ROM, mapped at $8000.
+ *
+ * See SMBData.cpp for the contents.
+ */
+extern const uint8_t smbConstantData[0x8000];
+
+class AreaCache;
+class RomImage;
+class SMBEngine;
+
+/**
+ * Snapshot of the state of an SMBEngine that changes while the game runs
+ * (CPU, RAM, PPU and controllers). The APU is not included.
+ */
+class SMBEngineState
+{
+    friend class SMBEngine;
+public:
+    /**
+     * Create an empty snapshot for use with the given engine.
+     */
+    explicit SMBEngineState(SMBEngine& engine);
+
+    ~SMBEngineState();
+
+    /**
+     * Read a snapshot written by write().
+     *
+     * @return false if the file ended early.
+     */
+    bool read(FILE* file);
+
+    /**
+     * Write the snapshot to a file. The layout is only meant to be read by
+     * the same build of the program.
+     *
+     * @return false if the snapshot could not be written.
+     */
+    bool write(FILE* file) const;
+
+private:
+    bool c;
+    bool z;
+    bool n;
+    uint8_t registerA;
+    uint8_t registerX;
+    uint8_t registerY;
+    uint8_t registerS;
+    uint8_t ram[0x800];
+    uint16_t returnIndexStack[100];
+    int returnIndexStackTop;
+    PPU* ppu;
+    Controller* controller1;
+    Controller* controller2;
+};
 
 /**
  * Engine that runs Super Mario Bros.
  * Handles emulation of various NES subsystems for compatibility and accuracy.
+ *
+ * All per-instance state (CPU, RAM, call stack, PPU, controllers and APU
+ * with its channels) lives in the object itself; the ROM, constant data and
+ * data pointers are shared. An instance is 4864 bytes on a 64-bit host. The
+ * only other allocation is the APU sample buffer (4 KB per output channel),
+ * made only if audio is enabled, so thousands of engines can run side by side.
  */
-class SMBEngine
+class alignas(SMBENGINE_ALIGNMENT) SMBEngine
 {
-    friend class MemoryAccess;
+    friend class AreaCache;
+    template <class CPU> friend class MemoryAccess;
     friend class PPU;
+    template <class CPU> friend class Register;
+    friend int measureAreaParser(const RomImage& rom, AreaCache& cache, std::ostream& stream);
 public:
     /**
      * Construct a new SMBEngine instance.
      *
-     * @param romImage the data from the Super Mario Bros. ROM image.
+     * @param rom the Super Mario Bros. ROM image. It must stay loaded while the engine exists.
+     * @param config the runtime options.
      */
-    explicit SMBEngine(uint8_t* romImage);
-
-    ~SMBEngine();
+    SMBEngine(const RomImage& rom, const RuntimeConfig& config);
 
     /**
      * Callback for handling audio buffering.
      */
     void audioCallback(uint8_t* stream, int length);
 
+    /**
+     * Get the audio processing unit.
+     */
+    APU& getAPU();
+
+    /**
+     * Get the picture processing unit.
+     */
+    PPU& getPPU();
+
+#ifdef SMB_VERIFY_NATIVE
+    /**
+     * Get the number of native routine calls whose results differed from the
+     * decompiled code in live play since the engine was created.
+     */
+    unsigned int getNativeMismatches() const;
+#endif
+
+    /**
+     * Get the number of areas in the game.
+     */
+    static int getAreaCount();
+
+    /**
+     * Get the value of AreaPointer that selects an area.
+     *
+     * @param area the index of the area, from 0 to getAreaCount() - 1.
+     */
+    static uint8_t getAreaPointer(int area);
+
     /**
      * Get player 1's controller.
      */
@@ -57,23 +157,62 @@ public:
     void renderFGObj(uint32_t* buffer);
 
     /**
-     * Reset the game engine to power-on state.
+     * Restore the state saved in a snapshot.
+     */
+    void loadState(const SMBEngineState& state);
+
+    /**
+     * Apply changed runtime options to the engine and its subsystems.
+     */
+    void reconfigure(const RuntimeConfig& config);
+
+    /**
+     * Replay native routine calls recorded by an SMB_VERIFY_NATIVE build (see
+     * setNativeCallRecording()): run each call through both the decompiled and
+     * the native routine from the recorded state and report any difference.
+     *
+     * @param file the recording.
+     * @param stream the stream to print differences and a summary to.
+     * @return the number of calls whose results differ, or -1 if the recording is not valid.
+     */
+    int replayNativeCalls(FILE* file, std::ostream& stream);
+
+    /**
+     * Reset the game engine to power-on state: clear the RAM, CPU registers,
+     * call stack, PPU and controllers, then run the game's reset routine.
+     * The APU and the runtime options are kept.
      */
     void reset();
 
+    /**
+     * Save the current state to a snapshot.
+     */
+    void saveState(SMBEngineState& state) const;
+
+#ifdef SMB_VERIFY_NATIVE
+    /**
+     * Append the state at the start of every verified native routine call to
+     * a file, for replayNativeCalls(), or stop recording with nullptr. The file
+     * must be empty or hold a recording made by this function.
+     */
+    void setNativeCallRecording(FILE* file);
+#endif
+
+    /**
+     * Suspend or resume audio. While suspended, APU register writes are
+     * dropped and the APU is not stepped, so frames can be run speculatively
+     * (e.g. for run-ahead) without being heard.
+     */
+    void setAudioSuspended(bool suspended);
+
     /**
      * Update the game engine by one frame.
      */
     void update();
 
 private:
-    // NES Emulation subsystems:
-    APU* apu;
-    PPU* ppu;
-    Controller* controller1;
-    Controller* controller2;
-
     // Fields for NES CPU emulation:
+    uint8_t ram[0x800];          /**< 2kb of RAM. */
     bool c;                      /**< Carry flag. */
     bool z;                      /**< Zero flag. */
     bool n;                      /**< Negative flag. */
@@ -82,19 +221,26 @@ private:
     uint8_t registerY;           /**< Y index register. */
     uint8_t registerS;           /**< Stack index register. */
     
-    MemoryAccess a;              /**< Wrapper for A register. */
-    MemoryAccess x;              /**< Wrapper for X register. */
-    MemoryAccess y;              /**< Wrapper for Y register. */
-    MemoryAccess s;              /**< Wrapper for S register. */
-    uint8_t dataStorage[0x8000]; /**< 32kb of storage for constant data. */
-    uint8_t ram[0x800];          /**< 2kb of RAM. */
-    uint8_t* chr;                /**< Pointer to CHR data from the ROM. */
-    unsigned int returnIndexStack[100];   /**< Stack for managing JSR subroutines. */
+    const uint8_t* chr;          /**< Pointer to CHR data from the ROM. */
+    uint16_t returnIndexStack[100];  /**< Stack for managing JSR subroutines. */
     int returnIndexStackTop;     /**< Current index of the top of the call stack. */
 
-    // Pointers to constant data used in the decompiled code
+    // NES Emulation subsystems:
+    PPU ppu;
+    Controller controller1;
+    Controller controller2;
+    APU apu;
+    bool audioSuspended;
+    RuntimeConfig config;
+#ifdef SMB_VERIFY_NATIVE
+    FILE* nativeCallRecording;   /**< Recording of native routine calls, or nullptr. */
+    SMBEngineState nativeCallState; /**< State at the start of the native routine being verified. */
+    unsigned int nativeMismatches; /**< Verified native routine calls whose results differed. */
+#endif
+
+    // Pointers to constant data used in the decompiled code, shared by all instances
     //
-    SMBDataPointers dataPointers;
+    static const SMBDataPointers dataPointers;
 
     /**
      * Run the decompiled code for the game.
@@ -102,9 +248,165 @@ private:
      * See SMB.cpp for implementation.
      *
      * @param mode the mode to run. 0 runs initialization routines, 1 runs the logic for frames.
+     * Other modes run a single subroutine (see SMB.hpp) and must be started with callDecompiled().
      */
     void code(int mode);
 
+    /**
+     * Call a decompiled subroutine from native code.
+     *
+     * @param mode the code() mode that runs the subroutine.
+     */
+    void callDecompiled(int mode);
+
+    //
+    // Native versions of decompiled routines. See SMBNative.cpp for implementation.
+    //
+
+    /**
+     * Native AreaParserCore: decode the next column of the area into the
+     * metatile buffer and the block buffer. Area objects are still processed
+     * by the decompiled ProcessAreaData.
+     */
+    void areaParserCore();
+
+    /**
+     * Native RenderSceneryTerrain: fill the metatile buffer with the background
+     * scenery, foreground scenery and terrain of the current column.
+     */
+    void renderSceneryTerrain();
+
+    /**
+     * Copy the solid metatiles of the metatile buffer to the current block buffer column.
+     */
+    void storeMetatileColumn();
+
+    /**
+     * Native IncrementColumnPos: move the area parser on to the next column.
+     */
+    void incrementColumnPos();
+
+    /**
+     * Reset the engine and initialize an area as if the player entered it from its start.
+     */
+    void initializeArea(uint8_t areaPointer);
+
+    /**
+     * Check if the area parser has reached the end of the area data.
+     */
+    bool isAtEndOfAreaData() const;
+
+    /**
+     * Native BlockBufferCollision: get the metatile in the block buffer at one
+     * of the probe points of an object (X), selected by Y.
+     */
+    void blockBufferCollision();
+
+    /**
+     * Get the metatile in the block buffer at a probe point of an object.
+     *
+     * @param object the sprite object slot.
+     * @param adder the probe point (offset into BlockBuffer_X_Adder and BlockBuffer_Y_Adder).
+     */
+    uint8_t getBlockBufferMetatile(uint8_t object, uint8_t adder);
+
+    /**
+     * Probe the block buffer at consecutive probe points of an object in one pass.
+     *
+     * @param object the sprite object slot.
+     * @param firstAdder the first probe point (offset into BlockBuffer_X_Adder and BlockBuffer_Y_Adder).
+     * @param probeCount the number of probe points, up to 8.
+     * @return a mask with bit n set if the metatile at probe point n is solid (as in CheckForSolidMTiles).
+     */
+    uint8_t getBackgroundSolidity(uint8_t object, uint8_t firstAdder, int probeCount);
+
+    /**
+     * Native MoveSpritesOffscreen: hide every sprite but sprite #0.
+     */
+    void moveSpritesOffscreen();
+
+    /**
+     * Native SpriteShuffler: rotate the OAM data offsets of the objects for
+     * the next frame and set up the offsets of the misc objects.
+     */
+    void spriteShuffler();
+
+    /**
+     * Native UpdateScreen: write the VRAM updates of the buffer at the pointer
+     * in $00 to the PPU, one run at a time, and reset the scroll.
+     */
+    void updateScreen();
+
+    /**
+     * Native EnemiesCollision: check the current enemy (X) against every lower
+     * enemy slot and process collisions between them.
+     */
+    void enemiesCollision();
+
+    /**
+     * Native SprObjectCollisionCore: check two bounding boxes for overlap.
+     *
+     * @param firstBox offset of the first bounding box from BoundingBox_UL_Corner.
+     * @param secondBox offset of the second bounding box from BoundingBox_UL_Corner.
+     * @return true if the boxes overlap.
+     */
+    bool boundingBoxCollision(uint8_t firstBox, uint8_t secondBox);
+
+    /**
+     * Check if an enemy slot takes part in enemy to enemy collisions.
+     */
+    bool canEnemyCollide(uint8_t slot);
+
+    /**
+     * Native routine that replaces a decompiled subroutine.
+     */
+    struct NativeRoutine
+    {
+        int mode;                    /**< code() mode that runs the decompiled subroutine. */
+        void (SMBEngine::*native)(); /**< The native routine. */
+        const char* name;            /**< Label of the decompiled subroutine. */
+        bool checkRegisters;         /**< Callers use every register and flag, not just X. */
+    };
+
+    /**
+     * Get the native routine that replaces the decompiled subroutine run by a code() mode, or nullptr.
+     */
+    static const NativeRoutine* getNativeRoutine(int mode);
+
+    /**
+     * Differential check of a native routine: run the decompiled subroutine,
+     * then the native routine from the same state, and report any difference
+     * in RAM, the PPU (see PPU::compareState()) or X (or any register and flag
+     * if the routine's checkRegisters is set). BlockBufferCollision calls also
+     * check getBackgroundSolidity() (see compareBackgroundSolidity()). The
+     * native routine's results are kept.
+     *
+     * @return true if the results match.
+     */
+    bool compareNative(const NativeRoutine& routine, const SMBEngineState& before, std::ostream& stream);
+
+    /**
+     * Differential check of getBackgroundSolidity(): probe the object (X) at
+     * up to 8 probe points from Y with the decompiled BlockBufferCollision and
+     * CheckForSolidMTiles, and compare the carries with the native mask.
+     *
+     * @return true if the results match.
+     */
+    bool compareBackgroundSolidity(const SMBEngineState& before, std::ostream& stream);
+
+#ifdef SMB_VERIFY_NATIVE
+    /**
+     * Check a native routine against its decompiled subroutine (see
+     * compareNative()) in live play, and record the call if recording.
+     */
+    void verifyNative(int mode);
+#endif
+
+    /**
+     * Clear the RAM, CPU registers, call stack, PPU and controllers.
+     */
+    void clearState();
+
     /**
      * Logic for CMP, CPY, and CPY instructions.
      */
@@ -113,22 +415,22 @@ private:
     /**
      * BIT instruction.
      */
-    void bit(uint8_t value);
+    void bit(uint8_t accumulator, uint8_t value);
 
     /**
      * Get CHR data from the ROM.
      */
-    uint8_t* getCHR();
+    const uint8_t* getCHR() const;
 
     /**
-     * Get a pointer to a byte in the address space.
+     * Get a pointer to a writable byte in the address space (RAM), or nullptr.
      */
-    uint8_t* getDataPointer(uint16_t address);
+    MEMORY_ACCESS_INLINE uint8_t* getDataPointer(uint16_t address);
 
     /**
      * Get a memory access object for a particular address.
      */
-    MemoryAccess getMemory(uint16_t address);
+    MEMORY_ACCESS_INLINE MemoryAccess<SMBEngine> getMemory(uint16_t address);
 
     /**
      * Get a word of memory from a zero-page address and the next byte (wrapped around),
@@ -136,22 +438,17 @@ private:
      */
     uint16_t getMemoryWord(uint8_t address);
 
-    /**
-     * Load all constant data that was present in the SMB ROM.
-     * 
-     * See SMBData.cpp for implementation.
-     */
-    void loadConstantData();
-
     /**
      * PHA instruction.
      */
-    void pha();
+    void pha(uint8_t accumulator);
 
     /**
      * PLA instruction.
+     *
+     * @return the pulled value, to be assigned to A.
      */
-    void pla();
+    uint8_t pla();
 
     /**
      * Pop an index from the call stack.
@@ -177,12 +474,34 @@ private:
      * Write data to an address in the NES address space.
      */
     void writeData(uint16_t address, uint8_t value);
-
-    /**
-     * Map constant data to the address space. The address must be at least 0x8000.
-     */
-    void writeData(uint16_t address, const uint8_t* data, unsigned int length);
-    //void writeData(uint16_t address, const uint8_t* data, std::size_t length);
 };
 
+//---------------------------------------------------------------------
+// Memory access for the decompiled code (inline, see MemoryAccess.hpp)
+//---------------------------------------------------------------------
+
+inline uint8_t* SMBEngine::getDataPointer(uint16_t address)
+{
+    // RAM and Mirrors
+    if( address < 0x2000 )
+    {
+        return ram + (address & 0x7ff);
+    }
+
+    return nullptr;
+}
+
+inline MemoryAccess<SMBEngine> SMBEngine::getMemory(uint16_t address)
+{
+    uint8_t* dataPointer = getDataPointer(address);
+    if( dataPointer != nullptr )
+    {
+        return MemoryAccess<SMBEngine>(*this, dataPointer);
+    }
+    else
+    {
+        return MemoryAccess<SMBEngine>(*this, readData(address));
+    }
+}
+
 #endif // SMBENGINE_HPP
@@ -0,0 +1,750 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "SMB.hpp"
+#include "SMBObjectTables.hpp"
+
+/**
+ * Get a pointer to a table in the constant data by its address in the ROM.
+ */
+static inline const uint8_t* romTable(uint16_t address)
+{
+    return smbConstantData + (address - 0x8000);
+}
+
+//---------------------------------------------------------------------
+// Calls between native and decompiled code
+//---------------------------------------------------------------------
+
+void SMBEngine::callDecompiled(int mode)
+{
+    // The decompiled subroutine returns to its caller when it pops this index
+    //
+    pushReturnIndex(NATIVE_RETURN_INDEX);
+    code(mode);
+}
+
+//---------------------------------------------------------------------
+// Differential checks of the native routines against the decompiled code
+//---------------------------------------------------------------------
+
+#define NATIVE_CALL_MAGIC "SMBNATV"   // Start of a native call recording
+#define NATIVE_CALL_VERSION 1
+#define NATIVE_CALL_MAX_MODE 15       // Largest code() mode counted by replayNativeCalls()
+#define BLOCK_BUFFER_ADDER_COUNT 28   // Probe points in BlockBuffer_X_Adder and BlockBuffer_Y_Adder
+
+const SMBEngine::NativeRoutine* SMBEngine::getNativeRoutine(int mode)
+{
+    static const NativeRoutine routines[] = {
+        { CODE_ENEMIES_COLLISION, &SMBEngine::enemiesCollision, "EnemiesCollision", false },
+        { CODE_AREA_PARSER_CORE, &SMBEngine::areaParserCore, "AreaParserCore", false },
+        { CODE_BLOCK_BUFFER_COLLISION, &SMBEngine::blockBufferCollision, "BlockBufferCollision", true },
+        { CODE_MOVE_SPRITES_OFFSCREEN, &SMBEngine::moveSpritesOffscreen, "MoveSpritesOffscreen", true },
+        { CODE_SPRITE_SHUFFLER, &SMBEngine::spriteShuffler, "SpriteShuffler", true },
+        { CODE_UPDATE_SCREEN, &SMBEngine::updateScreen, "UpdateScreen", true }
+    };
+
+    for (const NativeRoutine& routine : routines)
+    {
+        if (routine.mode == mode)
+        {
+            return &routine;
+        }
+    }
+    return nullptr;
+}
+
+bool SMBEngine::compareNative(const NativeRoutine& routine, const SMBEngineState& before, std::ostream& stream)
+{
+    // The solidity mask built on the same probes is checked with BlockBufferCollision,
+    // before the routines run for the results that are kept
+    //
+    bool match = (routine.mode != CODE_BLOCK_BUFFER_COLLISION) || compareBackgroundSolidity(before, stream);
+
+    // Run the decompiled routine first and keep its results
+    //
+    loadState(before);
+    callDecompiled(routine.mode);
+    uint8_t expectedRam[sizeof(ram)];
+    memcpy(expectedRam, ram, sizeof(ram));
+    uint8_t expectedRegisters[] = { registerA, registerX, registerY, c, z, n };
+    PPU expectedPpu(*this);
+    expectedPpu.copyState(ppu);
+
+    // Then run the native routine from the same state
+    //
+    loadState(before);
+    (this->*routine.native)();
+
+    for (unsigned int address = 0; address < sizeof(ram); address++)
+    {
+        if (ram[address] != expectedRam[address])
+        {
+            stream << "Native " << routine.name << " wrote $" << std::hex << (int)ram[address] << " to $" << address
+                << ", decompiled code wrote $" << (int)expectedRam[address] << std::dec << "\n";
+            match = false;
+            break;
+        }
+    }
+
+    // X is always checked, since callers use it as the object offset
+    //
+    uint8_t registers[] = { registerA, registerX, registerY, c, z, n };
+    const char* registerNames[] = { "A", "X", "Y", "C", "Z", "N" };
+    for (int i = 0; i < 6; i++)
+    {
+        if ((routine.checkRegisters || i == 1) && registers[i] != expectedRegisters[i])
+        {
+            stream << "Native " << routine.name << " left " << registerNames[i] << " = " << (int)registers[i]
+                << ", decompiled code left " << (int)expectedRegisters[i] << "\n";
+            match = false;
+        }
+    }
+
+    // Routines such as UpdateScreen write their results to the PPU
+    //
+    std::string nativeName = std::string("Native ") + routine.name;
+    if (!ppu.compareState(expectedPpu, nativeName.c_str(), stream))
+    {
+        match = false;
+    }
+
+    return match;
+}
+
+bool SMBEngine::compareBackgroundSolidity(const SMBEngineState& before, std::ostream& stream)
+{
+    loadState(before);
+    uint8_t object = registerX;
+    uint8_t firstAdder = registerY;
+    int probeCount = (firstAdder < BLOCK_BUFFER_ADDER_COUNT - 8) ? 8 : BLOCK_BUFFER_ADDER_COUNT - firstAdder;
+    uint8_t solidity = getBackgroundSolidity(object, firstAdder, probeCount);
+
+    uint8_t expectedSolidity = 0;
+    for (int probe = 0; probe < probeCount; probe++)
+    {
+        loadState(before);
+        registerY = firstAdder + probe;
+        callDecompiled(CODE_BLOCK_BUFFER_COLLISION);
+        callDecompiled(CODE_CHECK_FOR_SOLID_MTILES); // A holds the metatile found
+        expectedSolidity |= (c ? 1 : 0) << probe;
+    }
+
+    if (solidity != expectedSolidity)
+    {
+        stream << "Native background solidity of object " << (int)object << " from probe " << (int)firstAdder
+            << " is $" << std::hex << (int)solidity << ", decompiled probes give $" << (int)expectedSolidity << std::dec << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+int SMBEngine::replayNativeCalls(FILE* file, std::ostream& stream)
+{
+    char magic[sizeof(NATIVE_CALL_MAGIC)];
+    uint8_t version;
+    if (fread(magic, sizeof(magic), 1, file) != 1 || memcmp(magic, NATIVE_CALL_MAGIC, sizeof(magic)) != 0 ||
+        fread(&version, sizeof(version), 1, file) != 1 || version != NATIVE_CALL_VERSION)
+    {
+        stream << "Not a native call recording.\n";
+        return -1;
+    }
+
+    SMBEngineState state(*this);
+    int calls[NATIVE_CALL_MAX_MODE + 1] = {};
+    int mismatches[NATIVE_CALL_MAX_MODE + 1] = {};
+    int totalMismatches = 0;
+
+    // Each record is the code() mode of the routine followed by the state at the call
+    //
+    uint8_t mode;
+    while (fread(&mode, sizeof(mode), 1, file) == 1)
+    {
+        const NativeRoutine* routine = (mode <= NATIVE_CALL_MAX_MODE) ? getNativeRoutine(mode) : nullptr;
+        if (routine == nullptr || !state.read(file))
+        {
+            stream << "The native call recording is truncated or corrupt.\n";
+            return -1;
+        }
+
+        calls[mode]++;
+        if (!compareNative(*routine, state, stream))
+        {
+            mismatches[mode]++;
+            totalMismatches++;
+        }
+    }
+
+    for (int i = 0; i <= NATIVE_CALL_MAX_MODE; i++)
+    {
+        if (calls[i] > 0)
+        {
+            stream << getNativeRoutine(i)->name << ": " << calls[i] << " calls, " << mismatches[i] << " differ\n";
+        }
+    }
+
+    return totalMismatches;
+}
+
+#ifdef SMB_VERIFY_NATIVE
+void SMBEngine::setNativeCallRecording(FILE* file)
+{
+    if (file != nullptr && ftell(file) == 0)
+    {
+        uint8_t version = NATIVE_CALL_VERSION;
+        fwrite(NATIVE_CALL_MAGIC, sizeof(NATIVE_CALL_MAGIC), 1, file);
+        fwrite(&version, sizeof(version), 1, file);
+    }
+    nativeCallRecording = file;
+}
+
+unsigned int SMBEngine::getNativeMismatches() const
+{
+    return nativeMismatches;
+}
+
+void SMBEngine::verifyNative(int mode)
+{
+    saveState(nativeCallState);
+
+    if (nativeCallRecording != nullptr)
+    {
+        uint8_t recordedMode = mode;
+        fwrite(&recordedMode, sizeof(recordedMode), 1, nativeCallRecording);
+        nativeCallState.write(nativeCallRecording);
+    }
+
+    if (!compareNative(*getNativeRoutine(mode), nativeCallState, std::cout))
+    {
+        nativeMismatches++;
+    }
+}
+#endif
+
+//---------------------------------------------------------------------
+// Enemy to enemy collisions (EnemiesCollision in SMB.cpp)
+//---------------------------------------------------------------------
+
+/**
+ * Check if the enemy in a slot takes part in enemy to enemy collisions:
+ * any enemy below $15 except lakitu and piranha plants, that is fully on screen.
+ */
+bool SMBEngine::canEnemyCollide(uint8_t slot)
+{
+    EnemyTable enemies(ram);
+    uint8_t id = enemies.id(slot);
+    return (id < 0x15) & (id != Lakitu) & (id != PiranhaPlant) & (enemies.offscreenBitsMasked(slot) == 0);
+}
+
+/**
+ * Check one axis (left/right or top/bottom) of two bounding boxes for overlap,
+ * following the wraparound rules of SprObjectCollisionCore exactly.
+ */
+static inline bool boxAxisOverlap(uint8_t first1, uint8_t last1, uint8_t first2, uint8_t last2)
+{
+    // First box starts at or after the second
+    //
+    bool overlapAfter = (first1 == first2) | (first1 <= last2) | ((first1 > last1) & (last1 >= first2));
+
+    // First box starts before the second; a box whose end is before its start wraps around
+    //
+    bool overlapBefore = (first1 < last2) ?
+        ((last2 < first2) | (last1 >= first2)) :
+        ((first1 == last2) | (last1 < first1) | (last1 >= first2));
+
+    return (first1 >= first2) ? overlapAfter : overlapBefore;
+}
+
+bool SMBEngine::boundingBoxCollision(uint8_t firstBox, uint8_t secondBox)
+{
+    ObjectTable objects(ram);
+    BoundingBox first = objects.boundingBox(firstBox / 4);
+    BoundingBox second = objects.boundingBox(secondBox / 4);
+
+    // The vertical axis is only checked if the horizontal one overlaps;
+    // $07 counts down once per overlapping axis.
+    //
+    bool horizontal = boxAxisOverlap(first.left(), first.right(), second.left(), second.right());
+    bool vertical = horizontal && boxAxisOverlap(first.top(), first.bottom(), second.top(), second.bottom());
+
+    ram[0x06] = firstBox;
+    ram[0x07] = 1 - horizontal - vertical;
+    return vertical;
+}
+
+void SMBEngine::enemiesCollision()
+{
+    // Enemies only collide with each other on odd frames, and never in water areas
+    //
+    if (!(ram[FrameCounter] & 0x01) || ram[AreaType] == 0)
+    {
+        return;
+    }
+
+    EnemyTable enemies(ram);
+    uint8_t slot = registerX;
+    uint8_t firstBox = ram[ObjectOffset] * 4 + 4;
+    uint8_t other = slot - 1;
+    if (!canEnemyCollide(slot) || (other & 0x80))
+    {
+        registerX = ram[ObjectOffset];
+        return;
+    }
+
+    // Check against every lower enemy slot. The first enemy's bounding box offset
+    // is kept on the 6502 stack while the pair is processed, like the original.
+    //
+    do
+    {
+        ram[0x01] = other;
+        ram[0x100 | registerS--] = firstBox;
+
+        if (enemies.flag(other) != 0 && canEnemyCollide(other))
+        {
+            bool collision = boundingBoxCollision(firstBox, other * 4 + 4);
+
+            uint8_t first = ram[ObjectOffset];
+            uint8_t second = ram[0x01];
+            uint8_t& collisionBits = enemies.collisionBits(second);
+            uint8_t setMask = romTable(SetBitsMask)[first];
+            uint8_t clearMask = romTable(ClearBitsMask)[first];
+
+            // Pairs with a defeated enemy (d7 set) always react. Otherwise a pair only
+            // reacts on the first frame it touches, tracked in the collision bits.
+            //
+            bool defeated = ((enemies.state(first) | enemies.state(second)) & 0x80) != 0;
+            bool react = collision && (defeated || !(collisionBits & setMask));
+            uint8_t touchingBits = defeated ? collisionBits : (collisionBits | setMask);
+            collisionBits = collision ? touchingBits : (collisionBits & clearMask);
+
+            if (react)
+            {
+                registerX = first;
+                registerY = second;
+                callDecompiled(CODE_PROC_ENEMY_COLLISIONS);
+            }
+        }
+
+        firstBox = ram[0x100 | ++registerS];
+        other = ram[0x01] - 1;
+    }
+    while (!(other & 0x80));
+
+    registerX = ram[ObjectOffset];
+}
+
+//---------------------------------------------------------------------
+// Area parser (AreaParserCore in SMB.cpp)
+//---------------------------------------------------------------------
+
+void SMBEngine::areaParserCore()
+{
+    // When starting right of the beginning of the area, area objects are loaded first
+    //
+    if (ram[BackloadingFlag] != 0)
+    {
+        callDecompiled(CODE_PROCESS_AREA_DATA);
+    }
+
+    renderSceneryTerrain();
+    callDecompiled(CODE_PROCESS_AREA_DATA);
+    storeMetatileColumn();
+}
+
+void SMBEngine::renderSceneryTerrain()
+{
+    uint8_t* metatiles = ram + MetatileBuffer;
+    memset(metatiles, 0, METATILE_BUFFER_SIZE);
+
+    // Background scenery, which repeats every three pages. The carry chain of
+    // the original offset calculation is kept for out of range page numbers.
+    //
+    uint8_t backgroundScenery = ram[BackgroundScenery];
+    if (backgroundScenery != 0)
+    {
+        uint8_t page = ram[CurrentPageLoc];
+        while (!((page - 3) & 0x80))
+        {
+            page -= 3;
+        }
+        unsigned int sum = ((page << 4) & 0xff) + romTable(BSceneDataOffsets - 1)[backgroundScenery] + ((page >> 4) & 0x01);
+        sum = (sum & 0xff) + ram[CurrentColumnPos] + (sum >> 8);
+        uint8_t scenery = romTable(BackSceneryData)[sum & 0xff];
+
+        if (scenery != 0)
+        {
+            // Low nybble selects the scenery piece (3 metatiles each), high nybble the row
+            //
+            ram[0x100 | registerS] = scenery;
+            uint8_t piece = (scenery & 0x0f) - 1;
+            uint8_t source = ((piece << 1) & 0xff) + piece + (piece >> 7);
+            uint8_t row = scenery >> 4;
+            uint8_t remaining = 3;
+            while (true)
+            {
+                metatiles[row++] = romTable(BackSceneryMetatiles)[source++];
+                if (row == 0x0b || --remaining == 0)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    // Foreground scenery covers the whole column
+    //
+    uint8_t foregroundScenery = ram[ForegroundScenery];
+    if (foregroundScenery != 0)
+    {
+        uint8_t source = romTable(FSceneDataOffsets - 1)[foregroundScenery];
+        for (int row = 0; row < METATILE_BUFFER_SIZE; row++)
+        {
+            uint8_t metatile = romTable(ForeSceneryData)[source++];
+            if (metatile != 0)
+            {
+                metatiles[row] = metatile;
+            }
+        }
+    }
+
+    // Terrain, drawn from two bytes of bits (ceiling, then floor)
+    //
+    uint8_t areaType = ram[AreaType];
+    uint8_t terrain;
+    if (areaType == 0 && ram[WorldNumber] == World8)
+    {
+        terrain = 0x62;
+    }
+    else
+    {
+        terrain = ram[CloudTypeOverride] ? 0x88 : romTable(TerrainMetatiles)[areaType];
+    }
+
+    uint8_t renderBits = ram[TerrainControl] << 1;
+    uint8_t bits = 0;
+    int row = 0;
+    do
+    {
+        bits = romTable(TerrainRenderBits)[renderBits++];
+        if (ram[CloudTypeOverride] != 0 && row != 0)
+        {
+            bits &= 0x08;
+        }
+
+        for (int bit = 0; bit < 8 && row < METATILE_BUFFER_SIZE; bit++)
+        {
+            if (romTable(Bitmasks)[bit] & bits)
+            {
+                metatiles[row] = terrain;
+            }
+            row++;
+
+            // Underground areas always use ground metatiles for the bottom rows
+            //
+            if (areaType == 0x02 && row == 0x0b)
+            {
+                terrain = 0x54;
+            }
+        }
+    }
+    while (row < METATILE_BUFFER_SIZE && renderBits != 0);
+
+    ram[0x00] = bits;
+    ram[0x01] = renderBits;
+    ram[0x07] = terrain;
+}
+
+void SMBEngine::storeMetatileColumn()
+{
+    // GetBlockBufferAddr
+    //
+    uint8_t column = ram[BlockBufferColumnPos];
+    ram[0x100 | registerS] = column;
+    const uint8_t* blockBufferAddr = romTable(BlockBufferAddr);
+    ram[0x06] = (column & 0x0f) + blockBufferAddr[column >> 4];
+    ram[0x07] = blockBufferAddr[(column >> 4) + 2];
+    uint8_t* blockBuffer = ram + ((ram[0x07] << 8) | ram[0x06]);
+
+    // Metatiles below the lower bound of their palette are not solid and are
+    // stored as blank
+    //
+    const uint8_t* metatiles = ram + MetatileBuffer;
+    const uint8_t* lowBounds = romTable(BlockBuffLowBounds);
+    for (int row = 0; row < METATILE_BUFFER_SIZE; row++)
+    {
+        uint8_t metatile = metatiles[row];
+        blockBuffer[row * 0x10] = (metatile >= lowBounds[metatile >> 6]) ? metatile : 0;
+    }
+
+    ram[0x00] = (METATILE_BUFFER_SIZE - 1) * 0x10;
+    registerA = METATILE_BUFFER_SIZE * 0x10;
+    registerX = METATILE_BUFFER_SIZE;
+    registerY = METATILE_BUFFER_SIZE * 0x10;
+}
+
+//---------------------------------------------------------------------
+// Areas
+//---------------------------------------------------------------------
+
+int SMBEngine::getAreaCount()
+{
+    return dataPointers.AreaDataAddrHigh_ptr - dataPointers.AreaDataAddrLow_ptr;
+}
+
+uint8_t SMBEngine::getAreaPointer(int area)
+{
+    // The area data addresses are grouped by area type (water, ground,
+    // underground and castle), in the order of the area type offsets
+    //
+    const uint8_t* areaTypeOffsets = romTable(AreaDataHOffsets);
+    int areaType = 3;
+    while (areaType > 0 && area < areaTypeOffsets[areaType])
+    {
+        areaType--;
+    }
+    return (areaType << 5) | (area - areaTypeOffsets[areaType]);
+}
+
+void SMBEngine::initializeArea(uint8_t areaPointer)
+{
+    reset();
+    ram[AreaPointer] = areaPointer;
+    callDecompiled(CODE_INITIALIZE_AREA);
+}
+
+void SMBEngine::incrementColumnPos()
+{
+    ram[CurrentColumnPos] = (ram[CurrentColumnPos] + 1) & 0x0f;
+    if (ram[CurrentColumnPos] == 0)
+    {
+        ram[CurrentPageLoc]++;
+    }
+    ram[BlockBufferColumnPos] = (ram[BlockBufferColumnPos] + 1) & 0x1f;
+}
+
+bool SMBEngine::isAtEndOfAreaData() const
+{
+    uint16_t areaData = (ram[AreaData + 1] << 8) | ram[AreaData];
+    return areaData >= 0x8000 && smbConstantData[(areaData - 0x8000 + ram[AreaDataOffset]) & 0x7fff] == 0xfd;
+}
+
+//---------------------------------------------------------------------
+// Background collision (BlockBufferCollision in SMB.cpp)
+//---------------------------------------------------------------------
+
+/**
+ * Get the block buffer column (0-31) at a horizontal position in the level.
+ */
+static inline uint8_t getBlockBufferColumn(uint8_t page, unsigned int x)
+{
+    return (((page + (x >> 8)) & 0x01) << 4) | ((x & 0xff) >> 4);
+}
+
+uint8_t SMBEngine::getBlockBufferMetatile(uint8_t object, uint8_t adder)
+{
+    ObjectTable objects(ram);
+
+    // The horizontal position selects one of the 32 block buffer columns,
+    // the vertical position (less 32 pixels for the status bar) the row
+    //
+    unsigned int x = romTable(BlockBuffer_X_Adder)[adder] + objects.xPosition(object);
+    uint8_t column = getBlockBufferColumn(objects.pageLocation(object), x);
+    uint8_t row = ((objects.yPosition(object) + romTable(BlockBuffer_Y_Adder)[adder]) & 0xf0) - 0x20;
+
+    const uint8_t* blockBufferAddr = romTable(BlockBufferAddr);
+    uint16_t blockBuffer = (blockBufferAddr[(column >> 4) + 2] << 8) | (uint8_t)((column & 0x0f) + blockBufferAddr[column >> 4]);
+    return ram[blockBuffer + row];
+}
+
+void SMBEngine::blockBufferCollision()
+{
+    ObjectTable objects(ram);
+    uint8_t object = registerX;
+    uint8_t adder = registerY;
+
+    unsigned int x = romTable(BlockBuffer_X_Adder)[adder] + objects.xPosition(object);
+    uint8_t column = getBlockBufferColumn(objects.pageLocation(object), x);
+    uint8_t rowY = (objects.yPosition(object) + romTable(BlockBuffer_Y_Adder)[adder]) & 0xf0;
+    uint8_t metatile = getBlockBufferMetatile(object, adder);
+
+    // Mirror the scratch memory and stack writes of the original (including GetBlockBufferAddr)
+    //
+    const uint8_t* blockBufferAddr = romTable(BlockBufferAddr);
+    ram[0x100 | registerS] = registerA;
+    ram[0x100 | (uint8_t)(registerS - 1)] = column;
+    ram[0x02] = rowY - 0x20;
+    ram[0x03] = metatile;
+    ram[0x05] = x & 0xff;
+    ram[0x06] = (column & 0x0f) + blockBufferAddr[column >> 4];
+    ram[0x07] = blockBufferAddr[(column >> 4) + 2];
+
+    // A selects which coordinate's position within the metatile is returned in $04
+    //
+    ram[0x04] = (registerA ? objects.xPosition(object) : objects.yPosition(object)) & 0x0f;
+
+    registerA = metatile;
+    registerY = adder;
+    c = rowY >= 0x20;
+    setZN(metatile);
+}
+
+uint8_t SMBEngine::getBackgroundSolidity(uint8_t object, uint8_t firstAdder, int probeCount)
+{
+    const uint8_t* solidUpperBounds = romTable(SolidMTileUpperExt);
+    uint8_t solidity = 0;
+    for (int probe = 0; probe < probeCount; probe++)
+    {
+        // CheckForSolidMTiles: metatiles from the bound for their palette up are solid
+        //
+        uint8_t metatile = getBlockBufferMetatile(object, firstAdder + probe);
+        solidity |= (metatile >= solidUpperBounds[metatile >> 6]) << probe;
+    }
+
+    return solidity;
+}
+
+//---------------------------------------------------------------------
+// Sprites (MoveSpritesOffscreen and SpriteShuffler in SMB.cpp)
+//---------------------------------------------------------------------
+
+#define OAM_SPRITE_COUNT       64   // Sprites in OAM, 4 bytes each
+#define OAM_OFFSCREEN_Y        0xf8 // Y coordinate that hides a sprite below the screen
+#define SPR_DATA_OFFSET_COUNT  15   // Entries in SprDataOffset
+#define SPR_SHUFFLE_AMT_COUNT  3    // Entries in SprShuffleAmt
+#define SPR_SHUFFLE_FIRST      0x28 // OAM offset of the first shuffled sprite (#10)
+
+void SMBEngine::moveSpritesOffscreen()
+{
+    // Every sprite but sprite #0, which is used for the split scroll
+    //
+    for (int sprite = 1; sprite < OAM_SPRITE_COUNT; sprite++)
+    {
+        ram[Sprite_Y_Position + sprite * 4] = OAM_OFFSCREEN_Y;
+    }
+
+    // The original loop ends when Y wraps around to 0, setting the carry
+    //
+    registerA = OAM_OFFSCREEN_Y;
+    registerY = 0;
+    c = true;
+    setZN(registerY);
+}
+
+void SMBEngine::spriteShuffler()
+{
+    // Move every OAM data offset from sprite #10 up by the current shuffle
+    // amount, wrapping around to sprite #10 past the end of OAM, so objects
+    // past the limit of sprites per scanline flicker instead of vanishing
+    //
+    uint8_t amount = ram[SprShuffleAmt + ram[SprShuffleAmtOffset]];
+    ram[0x00] = SPR_SHUFFLE_FIRST;
+    for (int i = 0; i < SPR_DATA_OFFSET_COUNT; i++)
+    {
+        unsigned int offset = ram[SprDataOffset + i];
+        if (offset >= SPR_SHUFFLE_FIRST)
+        {
+            offset += amount;
+            ram[SprDataOffset + i] = (offset > 0xff) ? offset + SPR_SHUFFLE_FIRST : offset;
+        }
+    }
+
+    uint8_t shuffleAmountOffset = ram[SprShuffleAmtOffset] + 1;
+    ram[SprShuffleAmtOffset] = (shuffleAmountOffset == SPR_SHUFFLE_AMT_COUNT) ? 0 : shuffleAmountOffset;
+
+    // Misc objects share the OAM data offsets in SprDataOffset 5 to 7, three
+    // objects each, 8 bytes apart
+    //
+    for (int i = 0; i < 3; i++)
+    {
+        uint8_t offset = ram[SprDataOffset + 5 + i];
+        ram[Misc_SprDataOffset + i * 3] = offset;
+        ram[Misc_SprDataOffset + i * 3 + 1] = offset + 0x08;
+        ram[Misc_SprDataOffset + i * 3 + 2] = offset + 0x10;
+    }
+
+    // Leave the registers as the last pass of the original loop does
+    //
+    uint8_t lastOffset = ram[SprDataOffset + 5] + 0x08;
+    registerA = lastOffset + 0x08;
+    registerX = 0xff;
+    registerY = 0xff;
+    c = lastOffset >= 0xf8;
+    setZN(registerY);
+}
+
+//---------------------------------------------------------------------
+// Screen updates (UpdateScreen in SMB.cpp)
+//---------------------------------------------------------------------
+
+void SMBEngine::updateScreen()
+{
+    // Each entry of the buffer at the pointer in $00: VRAM address (high
+    // byte first, 0 ends the buffer), a control byte (d7: increment by 32,
+    // d6: repeat one byte, d5-d0: length) and the data
+    //
+    uint8_t run[0x100];
+    for (;;)
+    {
+        registerX = readData(PPU_STATUS); // reset flip-flop
+        uint16_t buffer = ram[0x00] | (ram[0x01] << 8);
+        uint8_t high = readData(buffer);
+        if (high == 0)
+        {
+            break;
+        }
+
+        uint8_t low = readData(buffer + 1);
+        writeData(PPU_ADDRESS, high);
+        writeData(PPU_ADDRESS, low);
+
+        uint8_t control = readData(buffer + 2);
+        ram[0x100 | registerS] = control << 1;
+        uint8_t ppuCtrl = (control & 0x80) ? (ram[Mirror_PPU_CTRL_REG1] | 0x04) : (ram[Mirror_PPU_CTRL_REG1] & ~0x04);
+        writeData(PPU_CTRL_REG1, ppuCtrl);
+        ram[Mirror_PPU_CTRL_REG1] = ppuCtrl;
+
+        // Gather the run (Y wraps around like the original index), then write
+        // it to VRAM in one go
+        //
+        bool repeat = (control & 0x40) != 0;
+        int length = (control & 0x3f) ? (control & 0x3f) : 0x100;
+        uint8_t y = 2;
+        if (repeat)
+        {
+            y++;
+            memset(run, readData(buffer + y), length);
+        }
+        else
+        {
+            for (int i = 0; i < length; i++)
+            {
+                y++;
+                run[i] = readData(buffer + y);
+            }
+        }
+        ppu.writeVRAMRun((high << 8) | low, run, length, (ppuCtrl & 0x04) ? 32 : 1);
+
+        // Move the pointer past the entry, then point VRAM at the palette and
+        // back to $0000 as the original does
+        //
+        unsigned int next = ram[0x00] + y + 1;
+        ram[0x00] = next & 0xff;
+        c = (ram[0x01] + (next >> 8)) > 0xff;
+        ram[0x01] += next >> 8;
+
+        writeData(PPU_ADDRESS, 0x3f);
+        writeData(PPU_ADDRESS, 0x00);
+        writeData(PPU_ADDRESS, 0x00);
+        writeData(PPU_ADDRESS, 0x00);
+    }
+
+    // InitScroll
+    //
+    writeData(PPU_SCROLL_REG, 0);
+    writeData(PPU_SCROLL_REG, 0);
+    registerA = 0;
+    registerY = 0;
+    setZN(registerA);
+}
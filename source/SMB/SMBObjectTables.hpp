@@ -0,0 +1,187 @@
+#ifndef SMBOBJECTTABLES_HPP
+#define SMBOBJECTTABLES_HPP
+
+#include <cstdint>
+
+#include "SMBConstants.hpp"
+
+// Typed views over the object tables in the game's RAM.
+//
+// The game keeps its objects as parallel byte arrays (one array per field,
+// indexed by slot). The views below only hold a pointer to the RAM and
+// alias the same bytes, so they compile down to the same indexed loads as
+// the decompiled code without going through MemoryAccess.
+//
+
+//---------------------------------------------------------------------
+// Slot layout
+//---------------------------------------------------------------------
+
+// Sprite object slots, as indexed from the SprObject_* tables
+//
+#define SPR_OBJECT_PLAYER   0  // Player_* tables start here
+#define SPR_OBJECT_ENEMY    1  // Enemy_* tables start here
+#define SPR_OBJECT_FIREBALL 7  // Fireball_* tables start here
+#define SPR_OBJECT_BLOCK    9  // Block_* tables start here
+#define SPR_OBJECT_MISC     13 // Misc_* tables start here
+#define SPR_OBJECT_BUBBLE   22 // Bubble_* tables start here (position tables only)
+#define SPR_OBJECT_COUNT    25 // Slots in the position tables, which include every object kind
+
+#define ENEMY_SLOT_COUNT    6  // Enemy slots (slot 5 is used for power-ups)
+
+static_assert(Enemy_X_Position == SprObject_X_Position + SPR_OBJECT_ENEMY, "Enemy slots must follow the player");
+static_assert(Misc_Y_Position == SprObject_Y_Position + SPR_OBJECT_MISC, "Misc slots must follow the blocks");
+static_assert(Bubble_PageLoc == SprObject_PageLoc + SPR_OBJECT_BUBBLE, "Bubble slots must follow the misc objects");
+
+// Bounding box slots (offset / 4 from BoundingBox_UL_Corner)
+//
+#define BOUNDING_BOX_PLAYER   0
+#define BOUNDING_BOX_ENEMY    1
+#define BOUNDING_BOX_FIREBALL 7
+#define BOUNDING_BOX_MISC     9
+#define BOUNDING_BOX_COUNT    18
+
+static_assert(EnemyBoundingBoxCoord == BoundingBox_UL_Corner + BOUNDING_BOX_ENEMY * 4, "Enemy boxes must follow the player box");
+
+// Level geometry
+//
+#define METATILE_BUFFER_SIZE 13 // Rows in a column of metatiles (MetatileBuffer)
+#define BLOCK_BUFFER_COLUMNS 16 // Columns in each of the two block buffers
+
+/**
+ * A run of consecutive bytes in RAM, such as one field of every object slot.
+ */
+class RamSpan
+{
+public:
+    RamSpan(uint8_t* data, uint8_t size) :
+        data(data),
+        length(size)
+    {
+    }
+
+    uint8_t& operator[](uint8_t index) const { return data[index]; }
+    uint8_t* begin() const { return data; }
+    uint8_t* end() const { return data + length; }
+    uint8_t size() const { return length; }
+
+private:
+    uint8_t* data;
+    uint8_t length;
+};
+
+/**
+ * View of one bounding box: the upper left and lower right corner in screen coordinates.
+ */
+class BoundingBox
+{
+public:
+    explicit BoundingBox(uint8_t* corners) :
+        corners(corners)
+    {
+    }
+
+    uint8_t& left() const { return corners[0]; }
+    uint8_t& top() const { return corners[1]; }
+    uint8_t& right() const { return corners[2]; }
+    uint8_t& bottom() const { return corners[3]; }
+
+    /**
+     * Get the box as a span of its 4 coordinates (left, top, right, bottom).
+     */
+    RamSpan coordinates() const { return RamSpan(corners, 4); }
+
+private:
+    uint8_t* corners;
+};
+
+//---------------------------------------------------------------------
+// Object tables
+//---------------------------------------------------------------------
+
+/**
+ * View of the sprite object tables, indexed by SPR_OBJECT_* slot.
+ * Only the position and speed tables cover every object kind; the other
+ * object kinds have tables of their own in SMBConstants.hpp.
+ */
+class ObjectTable
+{
+public:
+    explicit ObjectTable(uint8_t* ram) :
+        ram(ram)
+    {
+    }
+
+    uint8_t& pageLocation(uint8_t slot) const { return ram[SprObject_PageLoc + slot]; }
+    uint8_t& xPosition(uint8_t slot) const { return ram[SprObject_X_Position + slot]; }
+    uint8_t& yHighPosition(uint8_t slot) const { return ram[SprObject_Y_HighPos + slot]; }
+    uint8_t& yPosition(uint8_t slot) const { return ram[SprObject_Y_Position + slot]; }
+    int8_t& xSpeed(uint8_t slot) const { return reinterpret_cast<int8_t&>(ram[SprObject_X_Speed + slot]); }
+    int8_t& ySpeed(uint8_t slot) const { return reinterpret_cast<int8_t&>(ram[SprObject_Y_Speed + slot]); }
+
+    /**
+     * Get the level x coordinate of an object (page and position combined).
+     */
+    uint16_t levelX(uint8_t slot) const { return (pageLocation(slot) << 8) | xPosition(slot); }
+
+    RamSpan pageLocations() const { return RamSpan(ram + SprObject_PageLoc, SPR_OBJECT_COUNT); }
+    RamSpan xPositions() const { return RamSpan(ram + SprObject_X_Position, SPR_OBJECT_COUNT); }
+    RamSpan yHighPositions() const { return RamSpan(ram + SprObject_Y_HighPos, SPR_OBJECT_COUNT); }
+    RamSpan yPositions() const { return RamSpan(ram + SprObject_Y_Position, SPR_OBJECT_COUNT); }
+
+    /**
+     * Get a bounding box by BOUNDING_BOX_* slot.
+     */
+    BoundingBox boundingBox(uint8_t box) const { return BoundingBox(ram + BoundingBox_UL_Corner + box * 4); }
+
+    /**
+     * Get every bounding box coordinate as one span (4 bytes per box).
+     */
+    RamSpan boundingBoxes() const { return RamSpan(ram + BoundingBox_UL_Corner, BOUNDING_BOX_COUNT * 4); }
+
+private:
+    uint8_t* ram;
+};
+
+/**
+ * View of the enemy tables, indexed by enemy slot (0 to ENEMY_SLOT_COUNT - 1).
+ */
+class EnemyTable
+{
+public:
+    explicit EnemyTable(uint8_t* ram) :
+        ram(ram)
+    {
+    }
+
+    uint8_t& flag(uint8_t slot) const { return ram[Enemy_Flag + slot]; }
+    uint8_t& id(uint8_t slot) const { return ram[Enemy_ID + slot]; }
+    uint8_t& state(uint8_t slot) const { return ram[Enemy_State + slot]; }
+    uint8_t& movingDirection(uint8_t slot) const { return ram[Enemy_MovingDir + slot]; }
+    uint8_t& pageLocation(uint8_t slot) const { return ram[Enemy_PageLoc + slot]; }
+    uint8_t& xPosition(uint8_t slot) const { return ram[Enemy_X_Position + slot]; }
+    uint8_t& yHighPosition(uint8_t slot) const { return ram[Enemy_Y_HighPos + slot]; }
+    uint8_t& yPosition(uint8_t slot) const { return ram[Enemy_Y_Position + slot]; }
+    int8_t& xSpeed(uint8_t slot) const { return reinterpret_cast<int8_t&>(ram[Enemy_X_Speed + slot]); }
+    int8_t& ySpeed(uint8_t slot) const { return reinterpret_cast<int8_t&>(ram[Enemy_Y_Speed + slot]); }
+    uint8_t& boundBoxControl(uint8_t slot) const { return ram[Enemy_BoundBoxCtrl + slot]; }
+    uint8_t& collisionBits(uint8_t slot) const { return ram[Enemy_CollisionBits + slot]; }
+    uint8_t& offscreenBits(uint8_t slot) const { return ram[Enemy_OffscreenBits + slot]; }
+    uint8_t& offscreenBitsMasked(uint8_t slot) const { return ram[EnemyOffscrBitsMasked + slot]; }
+
+    /**
+     * Get the bounding box of an enemy slot.
+     */
+    BoundingBox boundingBox(uint8_t slot) const { return BoundingBox(ram + EnemyBoundingBoxCoord + slot * 4); }
+
+    RamSpan flags() const { return RamSpan(ram + Enemy_Flag, ENEMY_SLOT_COUNT); }
+    RamSpan ids() const { return RamSpan(ram + Enemy_ID, ENEMY_SLOT_COUNT); }
+    RamSpan states() const { return RamSpan(ram + Enemy_State, ENEMY_SLOT_COUNT); }
+    RamSpan xPositions() const { return RamSpan(ram + Enemy_X_Position, ENEMY_SLOT_COUNT); }
+    RamSpan yPositions() const { return RamSpan(ram + Enemy_Y_Position, ENEMY_SLOT_COUNT); }
+
+private:
+    uint8_t* ram;
+};
+
+#endif // SMBOBJECTTABLES_HPP
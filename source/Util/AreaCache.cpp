@@ -0,0 +1,204 @@
+#include <cstdio>
+#include <cstring>
+
+#include "../Configuration.hpp"
+#include "../SMB/SMB.hpp"
+#include "../SMB/SMBObjectTables.hpp"
+
+#include "AreaCache.hpp"
+
+#define AREA_CACHE_MAGIC "SMBAREA"
+#define AREA_CACHE_VERSION 1
+
+AreaCache::AreaCache()
+{
+}
+
+void AreaCache::build(const RomImage& rom)
+{
+    RuntimeConfig config = Configuration::getRuntimeConfig();
+    config.audioEnabled = false;
+    SMBEngine* engine = new SMBEngine(rom, config);
+    const uint8_t* ram = engine->ram;
+
+    areas.clear();
+    areas.resize(SMBEngine::getAreaCount());
+
+    for (size_t area = 0; area < areas.size(); area++)
+    {
+        CachedArea& cachedArea = areas[area];
+        cachedArea.areaPointer = SMBEngine::getAreaPointer(area);
+        cachedArea.columnCount = 0;
+        engine->initializeArea(cachedArea.areaPointer);
+
+        int trailingColumns = AREA_TRAILING_COLUMNS;
+        while (trailingColumns > 0 && cachedArea.columnCount < AREA_MAX_COLUMNS)
+        {
+            engine->areaParserCore();
+
+            // Keep the column as stored in the block buffer
+            //
+            uint8_t blockBufferColumn = ram[BlockBufferColumnPos];
+            const uint8_t* blockBuffer = ram + ((blockBufferColumn & BLOCK_BUFFER_COLUMNS) ? Block_Buffer_2 : Block_Buffer_1);
+            for (int row = 0; row < METATILE_BUFFER_SIZE; row++)
+            {
+                cachedArea.blocks.push_back(blockBuffer[row * BLOCK_BUFFER_COLUMNS + (blockBufferColumn & (BLOCK_BUFFER_COLUMNS - 1))]);
+            }
+
+            // Each attribute byte covers 2x2 metatiles, with the palette bits of
+            // the top left, top right, bottom left and bottom right metatiles from
+            // the low bits up (like RenderAreaGraphics)
+            //
+            if ((cachedArea.columnCount & 1) == 0)
+            {
+                cachedArea.attributes.resize(cachedArea.attributes.size() + AREA_ATTRIBUTE_ROWS);
+            }
+            uint8_t* attributes = &cachedArea.attributes[cachedArea.attributes.size() - AREA_ATTRIBUTE_ROWS];
+            bool rightColumn = (cachedArea.columnCount & 1) != 0;
+            for (int row = 0; row < METATILE_BUFFER_SIZE; row++)
+            {
+                uint8_t palette = ram[MetatileBuffer + row] & 0xc0;
+                int shift = (rightColumn ? 0 : 2) + ((row & 1) ? 0 : 4);
+                attributes[row / 2] |= palette >> shift;
+            }
+
+            cachedArea.columnCount++;
+            engine->incrementColumnPos();
+
+            if (engine->isAtEndOfAreaData())
+            {
+                trailingColumns--;
+            }
+        }
+    }
+
+    delete engine;
+}
+
+const CachedArea* AreaCache::getArea(uint8_t areaPointer) const
+{
+    for (const CachedArea& area : areas)
+    {
+        if (area.areaPointer == areaPointer)
+        {
+            return &area;
+        }
+    }
+
+    return nullptr;
+}
+
+int AreaCache::getAreaCount() const
+{
+    return static_cast<int>(areas.size());
+}
+
+bool AreaCache::load(const std::string& fileName)
+{
+    areas.clear();
+
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    // Header: magic, version and number of areas
+    //
+    char magic[sizeof(AREA_CACHE_MAGIC)];
+    uint8_t header[3];
+    bool valid = fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, AREA_CACHE_MAGIC, sizeof(magic)) == 0 &&
+        fread(header, sizeof(header), 1, file) == 1 && header[0] == AREA_CACHE_VERSION &&
+        ((header[1] | (header[2] << 8)) == SMBEngine::getAreaCount());
+
+    if (valid)
+    {
+        areas.resize(header[1] | (header[2] << 8));
+    }
+
+    // Each area: pointer, column count, then the block and attribute bytes
+    //
+    for (size_t i = 0; valid && i < areas.size(); i++)
+    {
+        CachedArea& area = areas[i];
+        uint8_t areaHeader[3];
+        valid = fread(areaHeader, sizeof(areaHeader), 1, file) == 1;
+        area.areaPointer = areaHeader[0];
+        area.columnCount = areaHeader[1] | (areaHeader[2] << 8);
+        valid = valid && area.columnCount <= AREA_MAX_COLUMNS;
+        if (valid)
+        {
+            area.blocks.resize(area.columnCount * METATILE_BUFFER_SIZE);
+            area.attributes.resize(((area.columnCount + 1) / 2) * AREA_ATTRIBUTE_ROWS);
+            valid = fread(area.blocks.data(), area.blocks.size(), 1, file) == 1 &&
+                fread(area.attributes.data(), area.attributes.size(), 1, file) == 1;
+        }
+    }
+
+    fclose(file);
+
+    if (!valid)
+    {
+        areas.clear();
+    }
+
+    return valid;
+}
+
+bool AreaCache::materialize(uint8_t areaPointer, uint8_t page, uint8_t* blockBuffers) const
+{
+    const CachedArea* area = getArea(areaPointer);
+    if (area == nullptr)
+    {
+        return false;
+    }
+
+    // The block buffers hold 32 columns, wrapping around every two pages
+    //
+    for (int i = 0; i < BLOCK_BUFFER_COLUMNS * 2; i++)
+    {
+        int column = page * BLOCK_BUFFER_COLUMNS + i;
+        int blockBufferColumn = column & (BLOCK_BUFFER_COLUMNS * 2 - 1);
+        uint8_t* destination = blockBuffers + (blockBufferColumn / BLOCK_BUFFER_COLUMNS) * AREA_BLOCK_BUFFER_SIZE +
+            (blockBufferColumn % BLOCK_BUFFER_COLUMNS);
+
+        for (int row = 0; row < METATILE_BUFFER_SIZE; row++)
+        {
+            destination[row * BLOCK_BUFFER_COLUMNS] = (column < area->columnCount) ?
+                area->blocks[column * METATILE_BUFFER_SIZE + row] : 0;
+        }
+    }
+
+    return true;
+}
+
+bool AreaCache::save(const std::string& fileName) const
+{
+    FILE* file = fopen(fileName.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    uint8_t header[3] = {
+        AREA_CACHE_VERSION,
+        static_cast<uint8_t>(areas.size() & 0xff),
+        static_cast<uint8_t>(areas.size() >> 8)
+    };
+    bool written = fwrite(AREA_CACHE_MAGIC, sizeof(AREA_CACHE_MAGIC), 1, file) == 1 &&
+        fwrite(header, sizeof(header), 1, file) == 1;
+
+    for (const CachedArea& area : areas)
+    {
+        uint8_t areaHeader[3] = {
+            area.areaPointer,
+            static_cast<uint8_t>(area.columnCount & 0xff),
+            static_cast<uint8_t>(area.columnCount >> 8)
+        };
+        written = written && fwrite(areaHeader, sizeof(areaHeader), 1, file) == 1 &&
+            fwrite(area.blocks.data(), area.blocks.size(), 1, file) == 1 &&
+            fwrite(area.attributes.data(), area.attributes.size(), 1, file) == 1;
+    }
+
+    return (fclose(file) == 0) && written;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file
+ * @brief defines the cache of decoded area columns.
+ */
+#ifndef AREACACHE_HPP
+#define AREACACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define AREA_TRAILING_COLUMNS 32   // Columns decoded after the end of the area data (two screens)
+#define AREA_MAX_COLUMNS 0x1000    // Upper limit of columns decoded per area
+#define AREA_ATTRIBUTE_ROWS 7      // Attribute table bytes for each pair of columns
+#define AREA_BLOCK_BUFFER_SIZE 0xd0 // Bytes in each of the two block buffers
+
+class RomImage;
+
+/**
+ * Decoded columns of one area, as the area parser produces them when the
+ * area is entered from its start.
+ */
+struct CachedArea
+{
+    uint8_t areaPointer;             /**< Value of AreaPointer that selects the area. */
+    int columnCount;                 /**< Number of decoded columns. */
+    std::vector<uint8_t> blocks;     /**< Block buffer contents, METATILE_BUFFER_SIZE bytes per column. */
+    std::vector<uint8_t> attributes; /**< Attribute table bytes, AREA_ATTRIBUTE_ROWS per pair of columns. */
+};
+
+/**
+ * Cache of every area of the game, fully decoded.
+ *
+ * The game decodes an area one column at a time as the screen scrolls. The
+ * cache runs the area parser over every area once (on first run, or offline
+ * with the result saved to a file), so tools and batch workloads can get the
+ * level geometry of any area, or fill a whole block buffer window, in one pass.
+ * The cached columns are the area as built; blocks changed during play (broken
+ * bricks, collected coins) are not reflected.
+ */
+class AreaCache
+{
+public:
+    AreaCache();
+
+    /**
+     * Decode every area of the game.
+     *
+     * @param rom the ROM image.
+     */
+    void build(const RomImage& rom);
+
+    /**
+     * Get a decoded area, or nullptr if it is not cached.
+     */
+    const CachedArea* getArea(uint8_t areaPointer) const;
+
+    /**
+     * Get the number of cached areas.
+     */
+    int getAreaCount() const;
+
+    /**
+     * Load a cache saved with save(). Any previously cached areas are discarded.
+     *
+     * @return false if the file could not be read or is not a valid cache.
+     */
+    bool load(const std::string& fileName);
+
+    /**
+     * Fill both block buffers with the columns of an area as they are when the
+     * screen starts at a page: that page and the next one.
+     *
+     * @param areaPointer the area.
+     * @param page the page at the left of the screen.
+     * @param blockBuffers 2 * AREA_BLOCK_BUFFER_SIZE bytes, laid out like Block_Buffer_1 and Block_Buffer_2.
+     * @return false if the area is not cached.
+     */
+    bool materialize(uint8_t areaPointer, uint8_t page, uint8_t* blockBuffers) const;
+
+    /**
+     * Save the cache to a file.
+     *
+     * @return false if the file could not be written.
+     */
+    bool save(const std::string& fileName) const;
+
+private:
+    std::vector<CachedArea> areas;
+};
+
+#endif // AREACACHE_HPP
@@ -0,0 +1,166 @@
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#include "../Configuration.hpp"
+#include "../SMB/SMB.hpp"
+#include "../SMB/SMBObjectTables.hpp"
+
+#include "AreaCache.hpp"
+#include "AreaParserBenchmark.hpp"
+#include "Timer.hpp"
+
+int measureAreaParser(const RomImage& rom, AreaCache& cache, std::ostream& stream)
+{
+    if (cache.getAreaCount() == 0)
+    {
+        cache.build(rom);
+    }
+
+    RuntimeConfig config = Configuration::getRuntimeConfig();
+    config.audioEnabled = false;
+
+    SMBEngine* nativeEngine = new SMBEngine(rom, config);
+    SMBEngine* decompiledEngine = new SMBEngine(rom, config);
+
+    uint64_t nativeTicks = 0;
+    uint64_t decompiledTicks = 0;
+    uint64_t firstScreensTicks = 0;
+    uint64_t cacheTicks = 0;
+    int totalColumns = 0;
+    int mismatches = 0;
+    uint8_t blockBuffers[AREA_BLOCK_BUFFER_SIZE * 2];
+
+    stream << "area  columns  native us/column  decompiled us/column\n";
+
+    int areaCount = SMBEngine::getAreaCount();
+    for (int area = 0; area < areaCount; area++)
+    {
+        uint8_t areaPointer = SMBEngine::getAreaPointer(area);
+        const CachedArea* cachedArea = cache.getArea(areaPointer);
+        nativeEngine->initializeArea(areaPointer);
+        decompiledEngine->initializeArea(areaPointer);
+        bool attributesMatch = true;
+
+        uint64_t areaNativeTicks = 0;
+        uint64_t areaDecompiledTicks = 0;
+        int columns = 0;
+        int trailingColumns = AREA_TRAILING_COLUMNS;
+
+        while (trailingColumns > 0 && columns < AREA_MAX_COLUMNS)
+        {
+            uint64_t start = getTicks();
+            nativeEngine->areaParserCore();
+            uint64_t middle = getTicks();
+            decompiledEngine->callDecompiled(CODE_AREA_PARSER_CORE);
+            uint64_t end = getTicks();
+
+            areaNativeTicks += middle - start;
+            areaDecompiledTicks += end - middle;
+            columns++;
+
+            if (memcmp(nativeEngine->ram, decompiledEngine->ram, sizeof(nativeEngine->ram)) != 0)
+            {
+                for (unsigned int address = 0; address < sizeof(nativeEngine->ram); address++)
+                {
+                    if (nativeEngine->ram[address] != decompiledEngine->ram[address])
+                    {
+                        stream << "Area $" << std::hex << static_cast<int>(areaPointer) << " column " << std::dec << columns
+                            << ": native parser wrote " << static_cast<int>(nativeEngine->ram[address])
+                            << " to $" << std::hex << address << ", decompiled parser wrote "
+                            << static_cast<int>(decompiledEngine->ram[address]) << std::dec << "\n";
+                        break;
+                    }
+                }
+                mismatches++;
+                break;
+            }
+
+            // Render the column with the decompiled code as the game does before
+            // moving on, and the attribute table bytes after every second column,
+            // which must match the cached ones (both engines, to keep their RAM equal)
+            //
+            for (SMBEngine* engine : { nativeEngine, decompiledEngine })
+            {
+                engine->ram[VRAM_Buffer2_Offset] = 0;
+                engine->callDecompiled(CODE_RENDER_AREA_GRAPHICS);
+                if ((columns & 1) == 0)
+                {
+                    engine->ram[VRAM_Buffer2_Offset] = 0;
+                    engine->callDecompiled(CODE_RENDER_ATTRIBUTE_TABLES);
+                }
+            }
+
+            if ((columns & 1) == 0 && attributesMatch && cachedArea != nullptr && columns <= cachedArea->columnCount)
+            {
+                const uint8_t* attributes = &cachedArea->attributes[(columns / 2 - 1) * AREA_ATTRIBUTE_ROWS];
+                for (int row = 0; row < AREA_ATTRIBUTE_ROWS; row++)
+                {
+                    // Each attribute table entry in the VRAM buffer is address (2), length and the byte
+                    //
+                    uint8_t rendered = decompiledEngine->ram[VRAM_Buffer2 + 3 + row * 4];
+                    if (rendered != attributes[row])
+                    {
+                        stream << "Area $" << std::hex << static_cast<int>(areaPointer) << std::dec << " columns "
+                            << columns - 1 << "-" << columns << ": cached attribute byte " << row << " is $" << std::hex
+                            << static_cast<int>(attributes[row]) << ", RenderAttributeTables wrote $"
+                            << static_cast<int>(rendered) << std::dec << "\n";
+                        attributesMatch = false;
+                        mismatches++;
+                        break;
+                    }
+                }
+            }
+
+            nativeEngine->incrementColumnPos();
+            decompiledEngine->incrementColumnPos();
+
+            // Once the first two pages are decoded, fill them from the cache as well
+            //
+            if (columns == BLOCK_BUFFER_COLUMNS * 2)
+            {
+                firstScreensTicks += areaNativeTicks;
+                uint64_t cacheStart = getTicks();
+                cache.materialize(areaPointer, 0, blockBuffers);
+                cacheTicks += getTicks() - cacheStart;
+
+                if (memcmp(blockBuffers, nativeEngine->ram + Block_Buffer_1, sizeof(blockBuffers)) != 0)
+                {
+                    stream << "Area $" << std::hex << static_cast<int>(areaPointer) << std::dec
+                        << ": cached block buffers differ from the decoded ones\n";
+                    mismatches++;
+                }
+            }
+
+            // Keep going for a couple of screens once the end of the area data is reached
+            //
+            if (nativeEngine->isAtEndOfAreaData())
+            {
+                trailingColumns--;
+            }
+        }
+
+        nativeTicks += areaNativeTicks;
+        decompiledTicks += areaDecompiledTicks;
+        totalColumns += columns;
+
+        stream << "  $" << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(areaPointer)
+            << std::dec << std::setfill(' ') << std::setw(9) << columns << std::fixed << std::setprecision(2)
+            << std::setw(18) << ticksToSeconds(areaNativeTicks) * 1e6 / columns
+            << std::setw(22) << ticksToSeconds(areaDecompiledTicks) * 1e6 / columns << "\n";
+    }
+
+    double nativeSeconds = ticksToSeconds(nativeTicks);
+    double decompiledSeconds = ticksToSeconds(decompiledTicks);
+    stream << areaCount << " areas, " << totalColumns << " columns: native " << std::fixed << std::setprecision(2)
+        << nativeSeconds * 1e6 / totalColumns << " us/column, decompiled " << decompiledSeconds * 1e6 / totalColumns
+        << " us/column (" << ((nativeSeconds > 0.0) ? decompiledSeconds / nativeSeconds : 0.0) << "x), "
+        << mismatches << " mismatches\n";
+    stream << "First two pages of each area: decoded in " << ticksToSeconds(firstScreensTicks) * 1e6 / areaCount
+        << " us, filled from the cache in " << ticksToSeconds(cacheTicks) * 1e6 / areaCount << " us\n";
+
+    delete nativeEngine;
+    delete decompiledEngine;
+
+    return mismatches;
+}
@@ -0,0 +1,31 @@
+/**
+ * @file
+ * @brief defines the benchmark for the native area parser.
+ */
+#ifndef AREAPARSERBENCHMARK_HPP
+#define AREAPARSERBENCHMARK_HPP
+
+#include <iosfwd>
+
+class AreaCache;
+class RomImage;
+
+/**
+ * Decode every column of every area with both the native and the decompiled
+ * area parser, check that both leave identical RAM after each column, and
+ * print the decode time per column for each.
+ *
+ * The first two pages of each area are also filled from the area cache and
+ * compared with the block buffers the parsers built, and the time to fill
+ * them is printed next to the time to decode them. The cached attribute
+ * bytes are compared with what the decompiled RenderAttributeTables writes
+ * for every pair of columns.
+ *
+ * @param rom the ROM image.
+ * @param cache the area cache. It is built first if it is empty.
+ * @param stream the stream to print the results to.
+ * @return the number of columns or areas where the results differed.
+ */
+int measureAreaParser(const RomImage& rom, AreaCache& cache, std::ostream& stream);
+
+#endif // AREAPARSERBENCHMARK_HPP
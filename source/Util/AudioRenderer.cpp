@@ -0,0 +1,115 @@
+#include "../Configuration.hpp"
+
+#include "../Emulation/APU.hpp"
+#include "../Emulation/APUTrace.hpp"
+#include "../Emulation/Controller.hpp"
+#include "../SMB/SMBEngine.hpp"
+
+#include "AudioRenderer.hpp"
+#include "Timer.hpp"
+#include "WavWriter.hpp"
+
+#define START_PRESS_FRAME 40 // Frame on which Start is pressed to leave the title screen
+#define START_PRESS_LENGTH 4 // Number of frames Start is held
+
+bool renderAudioToFile(SMBEngine& engine, const std::string& fileName, int frameCount, AudioRenderStats* stats)
+{
+    APU& apu = engine.getAPU();
+    Controller& controller1 = engine.getController1();
+
+    WavWriter writer;
+    if (!writer.open(fileName, Configuration::getAudioFrequency(), apu.getChannelCount()))
+    {
+        return false;
+    }
+
+    static uint8_t samples[AUDIO_BUFFER_LENGTH * AUDIO_MAX_CHANNELS];
+    bool success = true;
+    uint64_t updateTicks = 0;
+    uint64_t startTicks = getTicks();
+
+    for (int frame = 0; frame < frameCount && success; frame++)
+    {
+        controller1.setButtonState(BUTTON_START, frame >= START_PRESS_FRAME && frame < START_PRESS_FRAME + START_PRESS_LENGTH);
+
+        uint64_t updateStart = getTicks();
+        engine.update();
+        updateTicks += getTicks() - updateStart;
+
+        // Drain everything the APU produced this frame
+        //
+        int length = apu.output(samples, sizeof(samples));
+        if (length > 0)
+        {
+            success = writer.write(samples, length);
+        }
+    }
+
+    unsigned int bytes = writer.getDataLength();
+    writer.close();
+
+    if (stats != nullptr)
+    {
+        stats->frames = frameCount;
+        stats->bytes = bytes;
+        stats->updateSeconds = ticksToSeconds(updateTicks);
+        stats->totalSeconds = ticksToSeconds(getTicks() - startTicks);
+    }
+
+    return success;
+}
+
+bool renderTraceToFile(const std::string& traceFileName, const std::string& fileName, bool stereo, AudioRenderStats* stats)
+{
+    APUTracePlayer player;
+    if (!player.load(traceFileName))
+    {
+        return false;
+    }
+
+    RuntimeConfig config = Configuration::getRuntimeConfig();
+    APU* apu = new APU(config);
+    if (stereo)
+    {
+        apu->setOutputMode(AUDIO_OUTPUT_STEREO);
+    }
+
+    WavWriter writer;
+    if (!writer.open(fileName, config.audioFrequency, apu->getChannelCount()))
+    {
+        delete apu;
+        return false;
+    }
+
+    static uint8_t samples[AUDIO_BUFFER_LENGTH * AUDIO_MAX_CHANNELS];
+    bool success = true;
+    uint64_t updateTicks = 0;
+    uint64_t startTicks = getTicks();
+
+    while (success && !player.isFinished())
+    {
+        uint64_t updateStart = getTicks();
+        player.stepFrame(*apu);
+        updateTicks += getTicks() - updateStart;
+
+        int length = apu->output(samples, sizeof(samples));
+        if (length > 0)
+        {
+            success = writer.write(samples, length);
+        }
+    }
+
+    unsigned int bytes = writer.getDataLength();
+    writer.close();
+    delete apu;
+
+    if (stats != nullptr)
+    {
+        stats->frames = player.getFrameCount();
+        stats->bytes = bytes;
+        stats->updateSeconds = ticksToSeconds(updateTicks);
+        stats->totalSeconds = ticksToSeconds(getTicks() - startTicks);
+    }
+
+    return success;
+}
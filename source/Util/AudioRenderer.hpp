@@ -0,0 +1,51 @@
+/**
+ * @file
+ * @brief defines the offline (headless) audio renderer.
+ */
+#ifndef AUDIORENDERER_HPP
+#define AUDIORENDERER_HPP
+
+#include <string>
+
+class SMBEngine;
+
+/**
+ * Statistics gathered while rendering audio offline.
+ */
+struct AudioRenderStats
+{
+    int frames;             /**< Number of frames emulated. */
+    unsigned int bytes;     /**< Number of sample bytes written. */
+    double updateSeconds;   /**< Time spent emulating frames: SMBEngine::update(), or only the APU when replaying a trace. */
+    double totalSeconds;    /**< Wall time for the whole render, including file output. */
+};
+
+/**
+ * Run the engine as fast as possible without video or SDL, streaming the
+ * generated audio to a WAV file.
+ *
+ * Start is pressed once after the title screen appears so that the
+ * render covers actual gameplay music.
+ *
+ * @param engine the engine to run. It should have just been reset.
+ * @param fileName the WAV file to write.
+ * @param frameCount the number of frames to emulate.
+ * @param stats optional statistics output.
+ * @return true if the file was written successfully.
+ */
+bool renderAudioToFile(SMBEngine& engine, const std::string& fileName, int frameCount, AudioRenderStats* stats = nullptr);
+
+/**
+ * Replay a recorded APU register trace into a fresh APU and write the
+ * resulting audio to a WAV file. No game logic runs, so this measures
+ * synthesis throughput in isolation.
+ *
+ * @param traceFileName the APU trace to replay.
+ * @param fileName the WAV file to write.
+ * @param stereo true to render a stereo mix.
+ * @param stats optional statistics output.
+ * @return true if the trace was loaded and the file was written successfully.
+ */
+bool renderTraceToFile(const std::string& traceFileName, const std::string& fileName, bool stereo, AudioRenderStats* stats = nullptr);
+
+#endif // AUDIORENDERER_HPP
@@ -0,0 +1,227 @@
+#include <iomanip>
+#include <iostream>
+
+#include "../Configuration.hpp"
+#include "../SMB/SMBEngine.hpp"
+
+#include "BatchRunner.hpp"
+#include "Timer.hpp"
+
+#define START_PRESS_FRAME 40 // Frame on which Start is pressed to leave the title screen
+#define START_PRESS_LENGTH 4 // Number of frames Start is held
+
+BatchRunner::BatchRunner(const RomImage& rom, int instanceCount, int threadCount)
+{
+    // Engines in a batch are only stepped, never heard
+    //
+    RuntimeConfig config = Configuration::getRuntimeConfig();
+    config.audioEnabled = false;
+
+    engines.reserve(instanceCount);
+    for (int i = 0; i < instanceCount; i++)
+    {
+        engines.push_back(new SMBEngine(rom, config));
+    }
+
+    if (threadCount <= 0)
+    {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+        threadCount = (threadCount > 0) ? threadCount : 1;
+    }
+
+    stepButtons = nullptr;
+    generation = 0;
+    busyWorkers = 0;
+    stopping = false;
+    nextChunk = 0;
+    statistics = BatchStatistics();
+
+    // The calling thread is one of the workers
+    //
+    for (int i = 1; i < threadCount; i++)
+    {
+        workers.emplace_back(&BatchRunner::workerMain, this);
+    }
+}
+
+BatchRunner::~BatchRunner()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    startCondition.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    for (auto engine : engines)
+    {
+        delete engine;
+    }
+}
+
+SMBEngine& BatchRunner::getEngine(int index)
+{
+    return *engines[index];
+}
+
+int BatchRunner::getInstanceCount() const
+{
+    return static_cast<int>(engines.size());
+}
+
+const BatchStatistics& BatchRunner::getStatistics() const
+{
+    return statistics;
+}
+
+int BatchRunner::getThreadCount() const
+{
+    return static_cast<int>(workers.size()) + 1;
+}
+
+void BatchRunner::reset()
+{
+    for (auto engine : engines)
+    {
+        engine->reset();
+    }
+    statistics = BatchStatistics();
+}
+
+void BatchRunner::runChunks()
+{
+    int instanceCount = static_cast<int>(engines.size());
+    for (;;)
+    {
+        int first = nextChunk.fetch_add(1, std::memory_order_relaxed) * BATCH_CHUNK_SIZE;
+        if (first >= instanceCount)
+        {
+            break;
+        }
+
+        int last = (first + BATCH_CHUNK_SIZE < instanceCount) ? first + BATCH_CHUNK_SIZE : instanceCount;
+        for (int i = first; i < last; i++)
+        {
+            SMBEngine* engine = engines[i];
+            engine->getController1().setButtons(stepButtons[i] & 0xff);
+            engine->getController2().setButtons(stepButtons[i] >> 8);
+            engine->update();
+        }
+    }
+}
+
+void BatchRunner::step(const std::vector<uint16_t>& buttons)
+{
+    uint64_t startTicks = getTicks();
+
+    stepButtons = buttons.data();
+    nextChunk = 0;
+
+    // Wake the workers, take part in the step, then wait for the others to finish their chunks
+    //
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+        busyWorkers = static_cast<int>(workers.size());
+    }
+    startCondition.notify_all();
+
+    runChunks();
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCondition.wait(lock, [this] { return busyWorkers == 0; });
+    }
+
+    statistics.steps++;
+    statistics.frames += engines.size();
+    statistics.seconds += ticksToSeconds(getTicks() - startTicks);
+}
+
+void BatchRunner::workerMain()
+{
+    uint64_t seenGeneration = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startCondition.wait(lock, [this, seenGeneration] { return stopping || generation != seenGeneration; });
+            if (stopping)
+            {
+                return;
+            }
+            seenGeneration = generation;
+        }
+
+        runChunks();
+
+        bool lastWorker;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            lastWorker = (--busyWorkers == 0);
+        }
+        if (lastWorker)
+        {
+            doneCondition.notify_one();
+        }
+    }
+}
+
+void measureBatchScaling(const RomImage& rom, int instanceCount, int frameCount, std::ostream& stream, int maxThreads)
+{
+    if (maxThreads <= 0)
+    {
+        maxThreads = static_cast<int>(std::thread::hardware_concurrency());
+        maxThreads = (maxThreads > 0) ? maxThreads : 1;
+    }
+
+    std::vector<uint16_t> buttons(instanceCount);
+    double singleThreadRate = 0.0;
+
+    stream << "Batch of " << instanceCount << " engines, " << frameCount << " frames each\n";
+    stream << "threads   frames/s  efficiency\n";
+
+    for (int threads = 1; threads <= maxThreads; threads++)
+    {
+        BatchRunner runner(rom, instanceCount, threads);
+        runner.reset();
+
+        // Leave the title screen, then give each engine its own pseudo-random input
+        //
+        uint32_t random = 1;
+        for (int frame = 0; frame < frameCount; frame++)
+        {
+            for (int i = 0; i < instanceCount; i++)
+            {
+                if (frame >= START_PRESS_FRAME && frame < START_PRESS_FRAME + START_PRESS_LENGTH)
+                {
+                    buttons[i] = 1 << BUTTON_START;
+                }
+                else if (frame < START_PRESS_FRAME + START_PRESS_LENGTH)
+                {
+                    buttons[i] = 0;
+                }
+                else if ((frame & 15) == 0)
+                {
+                    random = random * 1664525 + 1013904223;
+                    buttons[i] = (1 << BUTTON_RIGHT) | ((random >> 24) & ((1 << BUTTON_A) | (1 << BUTTON_B)));
+                }
+            }
+            runner.step(buttons);
+        }
+
+        const BatchStatistics& statistics = runner.getStatistics();
+        double rate = (statistics.seconds > 0.0) ? statistics.frames / statistics.seconds : 0.0;
+        if (threads == 1)
+        {
+            singleThreadRate = rate;
+        }
+        double efficiency = (singleThreadRate > 0.0) ? rate / (singleThreadRate * threads) : 0.0;
+
+        stream << std::setw(7) << threads << std::setw(11) << static_cast<int>(rate)
+            << std::setw(11) << std::fixed << std::setprecision(1) << efficiency * 100.0 << "%\n";
+    }
+}
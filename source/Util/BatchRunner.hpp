@@ -0,0 +1,120 @@
+/**
+ * @file
+ * @brief defines the batch runner that steps many games in parallel.
+ */
+#ifndef BATCHRUNNER_HPP
+#define BATCHRUNNER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define BATCH_CHUNK_SIZE 16 // Engines claimed by a worker at a time
+
+class RomImage;
+class SMBEngine;
+
+/**
+ * Counters describing the work done by a BatchRunner.
+ */
+struct BatchStatistics
+{
+    uint64_t steps;   /**< Calls to step(). */
+    uint64_t frames;  /**< Engine frames emulated (steps times instances). */
+    double seconds;   /**< Wall time spent in step(). */
+};
+
+/**
+ * Owns many independent SMBEngine instances and advances them all by one
+ * frame at a time across a pool of threads, for search and training
+ * workloads that do not need video or audio.
+ *
+ * Each step, the engines are split into chunks of BATCH_CHUNK_SIZE that
+ * workers claim from a shared counter, so threads that finish early take
+ * over work from slower ones. The calling thread works as well.
+ */
+class BatchRunner
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param rom the ROM image. It must stay loaded while the runner exists.
+     * @param instanceCount the number of engines.
+     * @param threadCount the number of threads stepping engines, including the
+     * calling thread, or 0 for one per hardware thread.
+     */
+    BatchRunner(const RomImage& rom, int instanceCount, int threadCount = 0);
+    ~BatchRunner();
+
+    /**
+     * Get one of the engines.
+     */
+    SMBEngine& getEngine(int index);
+
+    /**
+     * Get the number of engines.
+     */
+    int getInstanceCount() const;
+
+    /**
+     * Get the work counters.
+     */
+    const BatchStatistics& getStatistics() const;
+
+    /**
+     * Get the number of threads stepping engines, including the calling thread.
+     */
+    int getThreadCount() const;
+
+    /**
+     * Reset every engine to power-on state (see SMBEngine::reset()) and clear
+     * the work counters, so the next steps run as on freshly constructed engines.
+     */
+    void reset();
+
+    /**
+     * Set the controller buttons of every engine and advance all of them by one frame.
+     *
+     * @param buttons one entry per engine: player 1 buttons in the low byte and
+     * player 2 buttons in the high byte, one bit per ControllerButton.
+     */
+    void step(const std::vector<uint16_t>& buttons);
+
+private:
+    std::vector<SMBEngine*> engines;
+    std::vector<std::thread> workers;
+    const uint16_t* stepButtons;    /**< Buttons for the step in progress. */
+
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+    uint64_t generation;            /**< Incremented to start a step; guarded by mutex. */
+    int busyWorkers;                /**< Workers still running the current step; guarded by mutex. */
+    bool stopping;
+    std::atomic<int> nextChunk;     /**< Index of the next chunk to be claimed. */
+
+    BatchStatistics statistics;
+
+    void runChunks();
+    void workerMain();
+};
+
+/**
+ * Measure the throughput of a batch of engines with 1 thread up to one per
+ * hardware thread and print the frames per second and scaling efficiency
+ * (speedup divided by thread count) for each.
+ *
+ * @param rom the ROM image.
+ * @param instanceCount the number of engines.
+ * @param frameCount the number of frames to step each engine per measurement.
+ * @param stream the stream to print the results to.
+ * @param maxThreads the largest thread count to measure, or 0 for one per hardware thread.
+ */
+void measureBatchScaling(const RomImage& rom, int instanceCount, int frameCount, std::ostream& stream, int maxThreads = 0);
+
+#endif // BATCHRUNNER_HPP
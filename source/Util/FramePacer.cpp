@@ -0,0 +1,127 @@
+#include <cstring>
+#include <ostream>
+
+#ifdef __3DS__
+#include "3ds.h"
+#endif
+
+#include "FramePacer.hpp"
+#include "Timer.hpp"
+
+#define SPIN_US 200 // Sleep until this long before a deadline, then spin for better precision
+
+FramePacer::FramePacer(int frameRate, bool vsync) :
+    frameRate(frameRate),
+    vsync(vsync)
+{
+    ticksPerSecond = getTicksPerSecond();
+    reset();
+}
+
+uint64_t FramePacer::getDeadline() const
+{
+    return startTicks + deadlineFrame * ticksPerSecond / frameRate;
+}
+
+uint32_t FramePacer::getFrameCount() const
+{
+    return frameCount;
+}
+
+const uint32_t* FramePacer::getLatenessHistogram() const
+{
+    return latenessHistogram;
+}
+
+uint32_t FramePacer::getMissedDeadlines() const
+{
+    return missedDeadlines;
+}
+
+void FramePacer::printStatistics(std::ostream& stream) const
+{
+    stream << frameCount << " frames, " << missedDeadlines << " missed deadlines\n";
+    for (int i = 0; i < FRAME_PACER_HISTOGRAM_BUCKETS; i++)
+    {
+        if (latenessHistogram[i] == 0)
+        {
+            continue;
+        }
+        if (i == FRAME_PACER_HISTOGRAM_BUCKETS - 1)
+        {
+            stream << ">=" << i * FRAME_PACER_BUCKET_US << "us: " << latenessHistogram[i] << "\n";
+        }
+        else
+        {
+            stream << i * FRAME_PACER_BUCKET_US << "-" << (i + 1) * FRAME_PACER_BUCKET_US << "us: " << latenessHistogram[i] << "\n";
+        }
+    }
+}
+
+void FramePacer::recordLateness(uint64_t now, uint64_t deadline)
+{
+    uint64_t lateness = (now > deadline) ? now - deadline : 0;
+    uint64_t bucket = lateness * 1000000ULL / ticksPerSecond / FRAME_PACER_BUCKET_US;
+    if (bucket >= FRAME_PACER_HISTOGRAM_BUCKETS)
+    {
+        bucket = FRAME_PACER_HISTOGRAM_BUCKETS - 1;
+    }
+    latenessHistogram[bucket]++;
+}
+
+void FramePacer::reset()
+{
+    startTicks = getTicks();
+    deadlineFrame = 1;
+    frameCount = 0;
+    missedDeadlines = 0;
+    memset(latenessHistogram, 0, sizeof(latenessHistogram));
+}
+
+void FramePacer::waitForNextFrame()
+{
+    uint64_t deadline = getDeadline();
+    uint64_t now = getTicks();
+
+    if (now > deadline)
+    {
+        // The frame took too long. Count it, and start a new schedule from now rather
+        // than running the following frames faster to catch up.
+        //
+        missedDeadlines++;
+        recordLateness(now, deadline);
+        startTicks = now;
+        deadlineFrame = 1;
+        frameCount++;
+        return;
+    }
+
+#ifdef __3DS__
+    if (vsync)
+    {
+        gspWaitForVBlank();
+        now = getTicks();
+        recordLateness(now, deadline);
+
+        // Follow the display's timing
+        //
+        startTicks = now;
+        deadlineFrame = 1;
+        frameCount++;
+        return;
+    }
+#endif
+
+    uint64_t spinTicks = ticksPerSecond * SPIN_US / 1000000ULL;
+    if (deadline - now > spinTicks)
+    {
+        sleepTicks(deadline - now - spinTicks);
+    }
+    while ((now = getTicks()) < deadline)
+    {
+    }
+
+    recordLateness(now, deadline);
+    deadlineFrame++;
+    frameCount++;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file
+ * @brief defines the frame pacer used by the main loop.
+ */
+#ifndef FRAMEPACER_HPP
+#define FRAMEPACER_HPP
+
+#include <cstdint>
+#include <iosfwd>
+
+#define FRAME_PACER_HISTOGRAM_BUCKETS 33 // 250us buckets from 0 to 8ms, plus one for anything later
+#define FRAME_PACER_BUCKET_US 250
+
+/**
+ * Keeps the main loop running at a fixed frame rate.
+ *
+ * Frame deadlines are computed from the start time and the frame number
+ * using the high resolution system tick, so the fractional part of the
+ * frame period never accumulates into drift. Optionally, frames are
+ * synchronized to the display's vertical blank instead of a timer.
+ */
+class FramePacer
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param frameRate the desired frame rate (per second).
+     * @param vsync true to wait for the vertical blank instead of a timer.
+     */
+    FramePacer(int frameRate, bool vsync);
+
+    /**
+     * Get the number of frames paced so far.
+     */
+    uint32_t getFrameCount() const;
+
+    /**
+     * Get the histogram of how late each frame started compared to its deadline.
+     * Bucket i counts frames that were between i and i + 1 times FRAME_PACER_BUCKET_US late.
+     */
+    const uint32_t* getLatenessHistogram() const;
+
+    /**
+     * Get the number of frames whose work was not finished before their deadline.
+     */
+    uint32_t getMissedDeadlines() const;
+
+    /**
+     * Print the pacing statistics.
+     */
+    void printStatistics(std::ostream& stream) const;
+
+    /**
+     * Restart pacing from the current time and clear the statistics.
+     */
+    void reset();
+
+    /**
+     * Wait until it is time to start the next frame.
+     */
+    void waitForNextFrame();
+
+private:
+    uint64_t ticksPerSecond;
+    uint64_t startTicks;     /**< Time of the first deadline. */
+    uint64_t deadlineFrame;  /**< Number of frame periods between startTicks and the next deadline. */
+    int frameRate;
+    bool vsync;
+
+    uint32_t frameCount;
+    uint32_t missedDeadlines;
+    uint32_t latenessHistogram[FRAME_PACER_HISTOGRAM_BUCKETS];
+
+    uint64_t getDeadline() const;
+    void recordLateness(uint64_t now, uint64_t deadline);
+};
+
+#endif // FRAMEPACER_HPP
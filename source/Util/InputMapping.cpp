@@ -0,0 +1,131 @@
+#include <cstring>
+#include <sstream>
+
+#include "3ds.h"
+
+#include "InputMapping.hpp"
+
+/**
+ * Names of the 3DS keys that can be mapped.
+ */
+static const struct
+{
+    const char* name;
+    uint32_t keys;
+} keyNames[] = {
+    { "A", KEY_A },
+    { "B", KEY_B },
+    { "SELECT", KEY_SELECT },
+    { "START", KEY_START },
+    { "DRIGHT", KEY_DRIGHT },
+    { "DLEFT", KEY_DLEFT },
+    { "DUP", KEY_DUP },
+    { "DDOWN", KEY_DDOWN },
+    { "R", KEY_R },
+    { "L", KEY_L },
+    { "X", KEY_X },
+    { "Y", KEY_Y },
+    { "ZL", KEY_ZL },
+    { "ZR", KEY_ZR },
+    { "CSTICK_RIGHT", KEY_CSTICK_RIGHT },
+    { "CSTICK_LEFT", KEY_CSTICK_LEFT },
+    { "CSTICK_UP", KEY_CSTICK_UP },
+    { "CSTICK_DOWN", KEY_CSTICK_DOWN },
+    { "CPAD_RIGHT", KEY_CPAD_RIGHT },
+    { "CPAD_LEFT", KEY_CPAD_LEFT },
+    { "CPAD_UP", KEY_CPAD_UP },
+    { "CPAD_DOWN", KEY_CPAD_DOWN },
+    { "UP", KEY_UP },
+    { "DOWN", KEY_DOWN },
+    { "LEFT", KEY_LEFT },
+    { "RIGHT", KEY_RIGHT }
+};
+
+/**
+ * Names of the NES controller buttons, in ControllerButton order.
+ */
+static const char* buttonNames[] = {
+    "A", "B", "SELECT", "START", "UP", "DOWN", "LEFT", "RIGHT"
+};
+
+InputMapping::InputMapping()
+{
+    clear();
+}
+
+void InputMapping::clear()
+{
+    memset(table, 0, sizeof(table));
+}
+
+void InputMapping::map(uint32_t keys, int player, ControllerButton button)
+{
+    uint16_t bit = (1 << (int)button) << (player ? 8 : 0);
+
+    // Every table entry whose index has the key's bit set gets the button
+    //
+    for (int i = 0; i < 4; i++)
+    {
+        uint8_t keyByte = (keys >> (i * 8)) & 0xff;
+        if (keyByte == 0)
+        {
+            continue;
+        }
+        for (int index = 0; index < 256; index++)
+        {
+            if (index & keyByte)
+            {
+                table[i][index] |= bit;
+            }
+        }
+    }
+}
+
+bool InputMapping::parse(const std::string& mapping, int player)
+{
+    bool success = true;
+
+    std::istringstream stream(mapping);
+    std::string pair;
+    while (stream >> pair)
+    {
+        size_t separator = pair.find(':');
+        if (separator == std::string::npos)
+        {
+            success = false;
+            continue;
+        }
+        std::string keyName = pair.substr(0, separator);
+        std::string buttonName = pair.substr(separator + 1);
+
+        uint32_t keys = 0;
+        for (const auto& key : keyNames)
+        {
+            if (keyName == key.name)
+            {
+                keys = key.keys;
+                break;
+            }
+        }
+
+        int button = -1;
+        for (int i = 0; i < 8; i++)
+        {
+            if (buttonName == buttonNames[i])
+            {
+                button = i;
+                break;
+            }
+        }
+
+        if (keys == 0 || button < 0)
+        {
+            success = false;
+            continue;
+        }
+
+        map(keys, player, (ControllerButton)button);
+    }
+
+    return success;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file
+ * @brief defines the mapping from 3DS keys to NES controller buttons.
+ */
+#ifndef INPUTMAPPING_HPP
+#define INPUTMAPPING_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "../Emulation/Controller.hpp"
+
+/**
+ * Translates the held 3DS keys to the button state of both NES controllers.
+ *
+ * The mapping is kept as four 256-entry tables, one per byte of the key
+ * bitmask, holding the player 1 buttons in the low byte and the player 2
+ * buttons in the high byte. Translating the keys is four lookups ORed
+ * together, no matter how many keys are mapped.
+ */
+class InputMapping
+{
+public:
+    InputMapping();
+
+    /**
+     * Remove all mappings.
+     */
+    void clear();
+
+    /**
+     * Map one or more keys to a controller button.
+     *
+     * @param keys the 3DS key bitmask.
+     * @param player 0 for player 1, 1 for player 2.
+     * @param button the NES button.
+     */
+    void map(uint32_t keys, int player, ControllerButton button);
+
+    /**
+     * Add mappings from a string of space separated "KEY:BUTTON" pairs, e.g.
+     * "A:A X:B CPAD_UP:UP". Key names are the libctru KEY_ names without the
+     * prefix; button names are A, B, SELECT, START, UP, DOWN, LEFT and RIGHT.
+     *
+     * @return false if any pair could not be parsed. Valid pairs are still added.
+     */
+    bool parse(const std::string& mapping, int player);
+
+    /**
+     * Translate the held keys to button states.
+     *
+     * @return player 1 buttons in the low byte, player 2 buttons in the high byte.
+     */
+    uint16_t translate(uint32_t keys) const
+    {
+        return table[0][keys & 0xff] |
+            table[1][(keys >> 8) & 0xff] |
+            table[2][(keys >> 16) & 0xff] |
+            table[3][(keys >> 24) & 0xff];
+    }
+
+private:
+    uint16_t table[4][256];
+};
+
+#endif // INPUTMAPPING_HPP
@@ -0,0 +1,191 @@
+#include <cstring>
+#include <ostream>
+
+#include "../Configuration.hpp"
+
+#include "../Emulation/PPU.hpp"
+#include "../SMB/SMBEngine.hpp"
+
+#include "RenderPipeline.hpp"
+#include "Timer.hpp"
+
+#define RENDER_THREAD_STACK_SIZE (16 * 1024)
+#define RENDER_THREAD_PRIORITY 0x18
+
+RenderPipeline::RenderPipeline(SMBEngine& engine, PresentFunction present) :
+    engine(engine),
+    present(present)
+{
+    thread = nullptr;
+    running = false;
+
+    for (int i = 0; i < RENDER_QUEUE_LENGTH; i++)
+    {
+        snapshots[i] = new PPU(engine);
+    }
+    LightSemaphore_Init(&freeSlots, RENDER_QUEUE_LENGTH, RENDER_QUEUE_LENGTH);
+    LightSemaphore_Init(&readySlots, 0, RENDER_QUEUE_LENGTH);
+    writeIndex = 0;
+    readIndex = 0;
+
+    frameCount = 0;
+    updateTicks = 0;
+    submitWaitTicks = 0;
+    renderTicks = 0;
+    presentTicks = 0;
+
+    framePeriodTicks = getTicksPerSecond() / Configuration::getFrameRate();
+    latencyCount = 0;
+    latencyTicks = 0;
+    memset(latencyHistogram, 0, sizeof(latencyHistogram));
+}
+
+RenderPipeline::~RenderPipeline()
+{
+    stop();
+
+    for (int i = 0; i < RENDER_QUEUE_LENGTH; i++)
+    {
+        delete snapshots[i];
+    }
+}
+
+void RenderPipeline::printStatistics(std::ostream& stream) const
+{
+    if (frameCount == 0)
+    {
+        return;
+    }
+
+    double msPerTick = 1000.0 / getTicksPerSecond();
+    stream << "Per frame (ms): update " << updateTicks * msPerTick / frameCount
+        << ", submit wait " << submitWaitTicks * msPerTick / frameCount
+        << ", render " << renderTicks * msPerTick / frameCount
+        << ", present " << presentTicks * msPerTick / frameCount << "\n";
+
+    if (latencyCount > 0)
+    {
+        stream << "Input to present latency: " << (double)latencyTicks / framePeriodTicks / latencyCount << " frames average\n";
+        for (int i = 0; i < RENDER_LATENCY_BUCKETS; i++)
+        {
+            if (latencyHistogram[i] > 0)
+            {
+                stream << ((i == RENDER_LATENCY_BUCKETS - 1) ? ">" : "<=") << (i + 1) << " frames: " << latencyHistogram[i] << "\n";
+            }
+        }
+    }
+}
+
+void RenderPipeline::recordUpdateTicks(uint64_t ticks)
+{
+    updateTicks += ticks;
+}
+
+void RenderPipeline::renderLoop()
+{
+    while (true)
+    {
+        LightSemaphore_Acquire(&readySlots, 1);
+        if (!running)
+        {
+            break;
+        }
+
+        PPU& snapshot = *snapshots[readIndex];
+        uint64_t inputTicks = snapshotInputTicks[readIndex];
+
+        uint64_t startTicks = getTicks();
+        snapshot.renderBGColor(renderBuffer);
+        snapshot.renderBGObj(renderBuffer);
+        snapshot.renderBGNT(renderBuffer);
+        snapshot.renderFGObj(renderBuffer);
+        uint64_t renderedTicks = getTicks();
+
+        // The snapshot is no longer needed once rasterized
+        //
+        readIndex = (readIndex + 1) % RENDER_QUEUE_LENGTH;
+        LightSemaphore_Release(&freeSlots, 1);
+
+        present(renderBuffer);
+
+        uint64_t presentedTicks = getTicks();
+        renderTicks += renderedTicks - startTicks;
+        presentTicks += presentedTicks - renderedTicks;
+        frameCount++;
+
+        if (inputTicks != 0)
+        {
+            uint64_t latency = presentedTicks - inputTicks;
+            uint64_t bucket = latency / framePeriodTicks;
+            if (bucket >= RENDER_LATENCY_BUCKETS)
+            {
+                bucket = RENDER_LATENCY_BUCKETS - 1;
+            }
+            latencyHistogram[bucket]++;
+            latencyTicks += latency;
+            latencyCount++;
+        }
+    }
+}
+
+bool RenderPipeline::start(int core)
+{
+    running = true;
+    thread = threadCreate(threadMain, this, RENDER_THREAD_STACK_SIZE, RENDER_THREAD_PRIORITY, core, false);
+    if (thread == nullptr)
+    {
+        running = false;
+        return false;
+    }
+
+    return true;
+}
+
+void RenderPipeline::stop()
+{
+    if (thread == nullptr)
+    {
+        return;
+    }
+
+    // Let the render thread drain the queue, then wake it up to exit
+    //
+    LightSemaphore_Acquire(&freeSlots, RENDER_QUEUE_LENGTH);
+    running = false;
+    LightSemaphore_Release(&readySlots, 1);
+
+    threadJoin(thread, U64_MAX);
+    threadFree(thread);
+    thread = nullptr;
+
+    LightSemaphore_Init(&freeSlots, RENDER_QUEUE_LENGTH, RENDER_QUEUE_LENGTH);
+    LightSemaphore_Init(&readySlots, 0, RENDER_QUEUE_LENGTH);
+    writeIndex = 0;
+    readIndex = 0;
+}
+
+void RenderPipeline::submitFrame(uint64_t inputTicks)
+{
+    uint64_t startTicks = getTicks();
+    LightSemaphore_Acquire(&freeSlots, 1);
+    submitWaitTicks += getTicks() - startTicks;
+
+    snapshots[writeIndex]->copyRenderState(engine.getPPU());
+    snapshotInputTicks[writeIndex] = inputTicks;
+    writeIndex = (writeIndex + 1) % RENDER_QUEUE_LENGTH;
+
+    LightSemaphore_Release(&readySlots, 1);
+}
+
+void RenderPipeline::threadMain(void* arg)
+{
+    static_cast<RenderPipeline*>(arg)->renderLoop();
+}
+
+int getRenderCore()
+{
+    bool isNew3DS = false;
+    APT_CheckNew3DS(&isNew3DS);
+
+    return isNew3DS ? 2 : 1;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file
+ * @brief defines the pipelined frame renderer.
+ */
+#ifndef RENDERPIPELINE_HPP
+#define RENDERPIPELINE_HPP
+
+#include <cstdint>
+#include <iosfwd>
+
+#include "3ds.h"
+
+#include "../Constants.hpp"
+
+#define RENDER_QUEUE_LENGTH 2 // Number of PPU snapshots that can wait to be rendered
+#define RENDER_LATENCY_BUCKETS 8 // Input latency histogram: 0 to 6 frames, plus one for anything longer
+
+class PPU;
+class SMBEngine;
+
+/**
+ * Runs PPU rasterization and presentation on a separate core.
+ *
+ * After the game logic for frame N has run, submitFrame() copies the PPU
+ * state into a bounded queue of snapshots and returns, so frame N + 1's
+ * logic can run on the calling core while frame N is rendered and
+ * presented by the render thread.
+ */
+class RenderPipeline
+{
+public:
+    /**
+     * Function called on the render thread to show a finished frame.
+     */
+    typedef void (*PresentFunction)(const uint32_t* buffer);
+
+    /**
+     * Constructor.
+     *
+     * @param engine the engine whose PPU is rendered.
+     * @param present function that shows a rendered frame.
+     */
+    RenderPipeline(SMBEngine& engine, PresentFunction present);
+    ~RenderPipeline();
+
+    /**
+     * Print the per-stage timing statistics.
+     */
+    void printStatistics(std::ostream& stream) const;
+
+    /**
+     * Record the time the calling thread spent updating the game for the frame about to be submitted.
+     */
+    void recordUpdateTicks(uint64_t ticks);
+
+    /**
+     * Start the render thread.
+     *
+     * @param core the CPU core to run the render thread on.
+     * @return true if the thread was created.
+     */
+    bool start(int core);
+
+    /**
+     * Stop the render thread after it has presented all submitted frames.
+     */
+    void stop();
+
+    /**
+     * Queue the current PPU state for rendering. Blocks while the queue is full.
+     *
+     * @param inputTicks if not 0, the time at which the input that this frame
+     * responds to was sampled. The time until the frame is presented is
+     * recorded in the input latency histogram.
+     */
+    void submitFrame(uint64_t inputTicks = 0);
+
+private:
+    SMBEngine& engine;
+    PresentFunction present;
+    Thread thread;
+    volatile bool running;
+
+    PPU* snapshots[RENDER_QUEUE_LENGTH];
+    uint64_t snapshotInputTicks[RENDER_QUEUE_LENGTH];
+    LightSemaphore freeSlots;  /**< Snapshots that can be written by submitFrame(). */
+    LightSemaphore readySlots; /**< Snapshots waiting to be rendered. */
+    int writeIndex;
+    int readIndex;
+
+    uint32_t renderBuffer[RENDER_WIDTH * RENDER_HEIGHT];
+
+    // Per-stage timing
+    uint32_t frameCount;
+    uint64_t updateTicks;      /**< Game logic, on the submitting core. */
+    uint64_t submitWaitTicks;  /**< Time submitFrame() waited for a free snapshot. */
+    uint64_t renderTicks;      /**< Rasterization, on the render core. */
+    uint64_t presentTicks;     /**< Presentation, on the render core. */
+
+    // Input to present latency
+    uint64_t framePeriodTicks;
+    uint32_t latencyCount;
+    uint64_t latencyTicks;
+    uint32_t latencyHistogram[RENDER_LATENCY_BUCKETS]; /**< Bucket i counts presses shown within i + 1 frame periods. */
+
+    static void threadMain(void* arg);
+    void renderLoop();
+};
+
+/**
+ * Pick the core the render thread should use: the extra application core on
+ * New 3DS models, otherwise the system core.
+ */
+int getRenderCore();
+
+#endif // RENDERPIPELINE_HPP
@@ -0,0 +1,169 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifndef __3DS__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "RomImage.hpp"
+
+#ifdef __3DS__
+/**
+ * Storage for the ROM image. One byte larger than a valid image so that
+ * oversized files can be detected with the same read.
+ */
+static uint8_t romArena[ROM_IMAGE_SIZE + 1];
+#endif
+
+/**
+ * Compute the CRC-32 (IEEE 802.3) of a block of data.
+ */
+static uint32_t crc32(const uint8_t* data, size_t length)
+{
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+RomImage::RomImage()
+{
+    image = nullptr;
+    mappedLength = 0;
+}
+
+RomImage::~RomImage()
+{
+    unload();
+}
+
+const uint8_t* RomImage::getCHR() const
+{
+    return image + ROM_HEADER_SIZE + ROM_PRG_SIZE;
+}
+
+const uint8_t* RomImage::getPRG() const
+{
+    return image + ROM_HEADER_SIZE;
+}
+
+bool RomImage::isLoaded() const
+{
+    return image != nullptr;
+}
+
+bool RomImage::load(const std::string& fileName)
+{
+    unload();
+
+#ifdef __3DS__
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (file == nullptr)
+    {
+        std::cout << "Failed to open the file \"" << fileName << "\".\n";
+        return false;
+    }
+
+    size_t length = fread(romArena, 1, sizeof(romArena), file);
+    fclose(file);
+
+    if (!validate(romArena, length, fileName))
+    {
+        return false;
+    }
+    image = romArena;
+#else
+    int file = open(fileName.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        std::cout << "Failed to open the file \"" << fileName << "\".\n";
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size == 0)
+    {
+        std::cout << "Failed to read the file \"" << fileName << "\".\n";
+        close(file);
+        return false;
+    }
+
+    size_t length = static_cast<size_t>(status.st_size);
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (mapping == MAP_FAILED)
+    {
+        std::cout << "Failed to map the file \"" << fileName << "\".\n";
+        return false;
+    }
+
+    if (!validate(static_cast<const uint8_t*>(mapping), length, fileName))
+    {
+        munmap(mapping, length);
+        return false;
+    }
+    image = static_cast<const uint8_t*>(mapping);
+    mappedLength = length;
+#endif
+
+    return true;
+}
+
+void RomImage::unload()
+{
+#ifndef __3DS__
+    if (mappedLength != 0)
+    {
+        munmap(const_cast<uint8_t*>(image), mappedLength);
+    }
+#endif
+    image = nullptr;
+    mappedLength = 0;
+}
+
+bool RomImage::validate(const uint8_t* data, size_t length, const std::string& fileName) const
+{
+    if (length != ROM_IMAGE_SIZE)
+    {
+        std::cout << "\"" << fileName << "\" is " << length << " bytes, expected " << ROM_IMAGE_SIZE << ".\n";
+        return false;
+    }
+
+    // iNES header: "NES" EOF, PRG pages, CHR pages, flags 6 and 7.
+    // Super Mario Bros. has no trainer and uses mapper 0 (NROM). Old dumps may have
+    // junk in bytes 7-15, in which case flags 7 is ignored.
+    //
+    if (memcmp(data, "NES\x1a", 4) != 0)
+    {
+        std::cout << "\"" << fileName << "\" is not an iNES ROM image.\n";
+        return false;
+    }
+    uint8_t flags7 = (data[12] | data[13] | data[14] | data[15]) ? 0 : data[7];
+    uint8_t mapper = (data[6] >> 4) | (flags7 & 0xf0);
+    if (data[4] != ROM_PRG_SIZE / 0x4000 || data[5] != ROM_CHR_SIZE / 0x2000 || mapper != 0 || (data[6] & 0x04))
+    {
+        std::cout << "\"" << fileName << "\" is not a Super Mario Bros. ROM image (unexpected iNES header).\n";
+        return false;
+    }
+
+    uint32_t checksum = crc32(data + ROM_HEADER_SIZE, ROM_PRG_SIZE + ROM_CHR_SIZE);
+    if (checksum != ROM_PRG0_CRC32)
+    {
+        char hex[9];
+        snprintf(hex, sizeof(hex), "%08x", (unsigned int)checksum);
+        std::cout << "Warning: \"" << fileName << "\" has checksum " << hex
+            << " and is not the PRG0 revision. Graphics may be incorrect.\n";
+    }
+
+    return true;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file
+ * @brief defines the loader for the Super Mario Bros. ROM image.
+ */
+#ifndef ROMIMAGE_HPP
+#define ROMIMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#define ROM_HEADER_SIZE 16     // iNES header
+#define ROM_PRG_SIZE    0x8000 // 2 PRG pages of 16k each
+#define ROM_CHR_SIZE    0x2000 // 1 CHR page of 8k
+#define ROM_IMAGE_SIZE  (ROM_HEADER_SIZE + ROM_PRG_SIZE + ROM_CHR_SIZE)
+
+/**
+ * CRC-32 of the PRG and CHR data of "Super Mario Bros. (JU) (PRG0) [!].nes".
+ */
+#define ROM_PRG0_CRC32 0x3337ec46
+
+/**
+ * Read-only view of a validated Super Mario Bros. ROM image.
+ *
+ * The file is memory mapped where the platform supports it. On the 3DS it is
+ * read with a single call into a static arena, so there is only ever one image
+ * loaded at a time there.
+ */
+class RomImage
+{
+public:
+    RomImage();
+    ~RomImage();
+
+    /**
+     * Get the CHR data (pattern tables).
+     */
+    const uint8_t* getCHR() const;
+
+    /**
+     * Get the PRG data (program code and constant data).
+     */
+    const uint8_t* getPRG() const;
+
+    /**
+     * Check if an image is loaded.
+     */
+    bool isLoaded() const;
+
+    /**
+     * Load and validate a ROM image. Any previously loaded image is released.
+     *
+     * The iNES header must describe a mapper 0 image with 2 PRG pages and
+     * 1 CHR page. A checksum that does not match the PRG0 revision only
+     * prints a warning, since the game code itself does not come from the ROM.
+     *
+     * @return false if the file could not be read or is not a valid image.
+     */
+    bool load(const std::string& fileName);
+
+private:
+    const uint8_t* image; /**< Start of the iNES image, or nullptr. */
+    size_t mappedLength;  /**< Length of the memory mapping, or 0 if the image is not mapped. */
+
+    void unload();
+    bool validate(const uint8_t* data, size_t length, const std::string& fileName) const;
+};
+
+#endif // ROMIMAGE_HPP
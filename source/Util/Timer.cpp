@@ -0,0 +1,45 @@
+#ifdef __3DS__
+#include "3ds.h"
+#else
+#include <ctime>
+#endif
+
+#include "Timer.hpp"
+
+uint64_t getTicks()
+{
+#ifdef __3DS__
+    return svcGetSystemTick();
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+#endif
+}
+
+uint64_t getTicksPerSecond()
+{
+#ifdef __3DS__
+    return SYSCLOCK_ARM11;
+#else
+    return 1000000000ULL;
+#endif
+}
+
+void sleepTicks(uint64_t ticks)
+{
+    uint64_t nanoseconds = ticks * 1000000000ULL / getTicksPerSecond();
+#ifdef __3DS__
+    svcSleepThread(nanoseconds);
+#else
+    timespec duration;
+    duration.tv_sec = nanoseconds / 1000000000ULL;
+    duration.tv_nsec = nanoseconds % 1000000000ULL;
+    nanosleep(&duration, nullptr);
+#endif
+}
+
+double ticksToSeconds(uint64_t ticks)
+{
+    return static_cast<double>(ticks) / static_cast<double>(getTicksPerSecond());
+}
@@ -0,0 +1,30 @@
+/**
+ * @file
+ * @brief defines high resolution timing functions.
+ */
+#ifndef TIMER_HPP
+#define TIMER_HPP
+
+#include <cstdint>
+
+/**
+ * Get the current value of the high resolution system tick counter.
+ */
+uint64_t getTicks();
+
+/**
+ * Get the number of ticks per second returned by getTicks().
+ */
+uint64_t getTicksPerSecond();
+
+/**
+ * Suspend the calling thread for about the given number of ticks.
+ */
+void sleepTicks(uint64_t ticks);
+
+/**
+ * Convert a tick count to seconds.
+ */
+double ticksToSeconds(uint64_t ticks);
+
+#endif // TIMER_HPP
@@ -4,7 +4,7 @@
 
 #include "Video.hpp"
 
-void drawBox(uint32_t* buffer, unsigned int xOffset, unsigned int yOffset, unsigned int width, unsigned int height, uint32_t palette)
+void drawBox(uint32_t* buffer, const uint8_t* chr, unsigned int xOffset, unsigned int yOffset, unsigned int width, unsigned int height, uint32_t palette)
 {
     for (unsigned int y = 0; y < height; y++)
     {
@@ -56,18 +56,18 @@ void drawBox(uint32_t* buffer, unsigned int xOffset, unsigned int yOffset, unsig
                     tile = TILE_BOX_CENTER;
                 }
             }
-            drawCHRTile(buffer, xOffset + x << 3, yOffset + y << 3, tile, palette);
+            drawCHRTile(buffer, chr, xOffset + x << 3, yOffset + y << 3, tile, palette);
         }
     }
 }
 
-void drawCHRTile(uint32_t* buffer, unsigned int xOffset, unsigned int yOffset, unsigned int tile, uint32_t palette)
+void drawCHRTile(uint32_t* buffer, const uint8_t* chr, unsigned int xOffset, unsigned int yOffset, unsigned int tile, uint32_t palette)
 {
     // Read the pixels of the tile
     for( unsigned int row = 0; row < 8; row++ )
     {
-        uint8_t plane1 = romImage[16 + 2 * 16384 + tile * 16 + row];
-        uint8_t plane2 = romImage[16 + 2 * 16384 + tile * 16 + row + 8];
+        uint8_t plane1 = chr[tile * 16 + row];
+        uint8_t plane2 = chr[tile * 16 + row + 8];
 
         for( unsigned int column = 0; column < 8; column++ )
         {
@@ -100,7 +100,7 @@ void drawCHRTile(uint32_t* buffer, unsigned int xOffset, unsigned int yOffset, u
     }
 }
 
-void drawText(uint32_t* buffer, unsigned int xOffset, unsigned int yOffset, const std::string& text, uint32_t palette)
+void drawText(uint32_t* buffer, const uint8_t* chr, unsigned int xOffset, unsigned int yOffset, const std::string& text, uint32_t palette)
 {
     for (size_t i = 0; i < text.length(); i++)
     {
@@ -134,7 +134,7 @@ void drawText(uint32_t* buffer, unsigned int xOffset, unsigned int yOffset, cons
         {
             tile = 256 + 46;
         }
-        drawCHRTile(buffer, xOffset + i << 3, yOffset, tile, palette);
+        drawCHRTile(buffer, chr, xOffset + i << 3, yOffset, tile, palette);
     }
 }
 
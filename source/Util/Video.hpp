@@ -8,8 +8,6 @@
 #include <cstdint>
 #include <string>
 
-#include <SDL/SDL.h>
-
 /**
  * Constants for specific tiles in CHR.
  */
@@ -29,17 +27,17 @@ enum Tile
 /**
  * Draw a box.
  */
-void drawBox(uint32_t* buffer, unsigned int xOffset, unsigned int yOffset, unsigned int width, unsigned int height, uint32_t palette = 0);
+void drawBox(uint32_t* buffer, const uint8_t* chr, unsigned int xOffset, unsigned int yOffset, unsigned int width, unsigned int height, uint32_t palette = 0);
 
 /**
  * Draw a tile from CHR memory.
  */
-void drawCHRTile(uint32_t* buffer, unsigned int xOffset, unsigned int yOffset, unsigned int tile, uint32_t palette = 0);
+void drawCHRTile(uint32_t* buffer, const uint8_t* chr, unsigned int xOffset, unsigned int yOffset, unsigned int tile, uint32_t palette = 0);
 
 /**
  * Draw a string using characters from CHR.
  */
-void drawText(uint32_t* buffer, unsigned int xOffset, unsigned int yOffset, const std::string& text, uint32_t palette = 0);
+void drawText(uint32_t* buffer, const uint8_t* chr, unsigned int xOffset, unsigned int yOffset, const std::string& text, uint32_t palette = 0);
 
 /**
  * Generate a texture for a scanline overlay effect.
@@ -52,6 +50,5 @@ void drawText(uint32_t* buffer, unsigned int xOffset, unsigned int yOffset, cons
 const uint32_t* loadPalette(const std::string& fileName);
 
 extern const uint32_t* paletteRGB;
-extern uint8_t* romImage;
 
 #endif // VIDEO_HPP
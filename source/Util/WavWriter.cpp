@@ -0,0 +1,101 @@
+#include "WavWriter.hpp"
+
+#define WAV_HEADER_LENGTH 44
+
+/**
+ * Store a 16-bit value in little-endian format.
+ */
+static void putWord(uint8_t* buffer, uint16_t value)
+{
+    buffer[0] = value & 0xff;
+    buffer[1] = (value >> 8) & 0xff;
+}
+
+/**
+ * Store a 32-bit value in little-endian format.
+ */
+static void putLong(uint8_t* buffer, uint32_t value)
+{
+    putWord(buffer, value & 0xffff);
+    putWord(buffer + 2, (value >> 16) & 0xffff);
+}
+
+WavWriter::WavWriter()
+{
+    file = nullptr;
+    dataLength = 0;
+}
+
+WavWriter::~WavWriter()
+{
+    close();
+}
+
+void WavWriter::close()
+{
+    if (file == nullptr)
+    {
+        return;
+    }
+
+    // Patch the RIFF and data chunk sizes now that the length is known
+    //
+    uint8_t size[4];
+    putLong(size, WAV_HEADER_LENGTH - 8 + dataLength);
+    fseek(file, 4, SEEK_SET);
+    fwrite(size, 1, sizeof(size), file);
+
+    putLong(size, dataLength);
+    fseek(file, WAV_HEADER_LENGTH - 4, SEEK_SET);
+    fwrite(size, 1, sizeof(size), file);
+
+    fclose(file);
+    file = nullptr;
+}
+
+uint32_t WavWriter::getDataLength() const
+{
+    return dataLength;
+}
+
+bool WavWriter::open(const std::string& fileName, int sampleRate, int channels)
+{
+    close();
+
+    file = fopen(fileName.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    dataLength = 0;
+
+    uint8_t header[WAV_HEADER_LENGTH] = {
+        'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 16, 0, 0, 0
+    };
+    putWord(header + 20, 1); // PCM
+    putWord(header + 22, channels);
+    putLong(header + 24, sampleRate);
+    putLong(header + 28, sampleRate * channels); // Byte rate
+    putWord(header + 32, channels); // Block alignment
+    putWord(header + 34, 8); // Bits per sample
+    header[36] = 'd';
+    header[37] = 'a';
+    header[38] = 't';
+    header[39] = 'a';
+
+    return fwrite(header, 1, sizeof(header), file) == sizeof(header);
+}
+
+bool WavWriter::write(const uint8_t* samples, int length)
+{
+    if (file == nullptr || length <= 0)
+    {
+        return false;
+    }
+
+    size_t written = fwrite(samples, 1, length, file);
+    dataLength += written;
+
+    return written == (size_t)length;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file
+ * @brief defines a streaming WAV file writer.
+ */
+#ifndef WAVWRITER_HPP
+#define WAVWRITER_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/**
+ * Writes unsigned 8-bit PCM samples to a WAV file as they are produced.
+ * The header sizes are patched when the file is closed.
+ */
+class WavWriter
+{
+public:
+    WavWriter();
+    ~WavWriter();
+
+    /**
+     * Close the file, finalizing the header.
+     */
+    void close();
+
+    /**
+     * Get the number of sample bytes written so far.
+     */
+    uint32_t getDataLength() const;
+
+    /**
+     * Open a file for writing and write a provisional header.
+     *
+     * @param fileName the file to create.
+     * @param sampleRate the sample rate, in Hz.
+     * @param channels the number of interleaved channels.
+     * @return true if the file was opened.
+     */
+    bool open(const std::string& fileName, int sampleRate, int channels);
+
+    /**
+     * Append interleaved samples to the file.
+     */
+    bool write(const uint8_t* samples, int length);
+
+private:
+    FILE* file;
+    uint32_t dataLength;
+};
+
+#endif // WAVWRITER_HPP
@@ -8,6 +8,8 @@
 extern "C" {
 #endif
 
+#ifdef __3DS__
+
 #include <3ds.h>
 
 typedef unsigned int uint;
@@ -20,6 +22,19 @@ static inline u32 quad8(u8 x)   {   x |= x<<8; return x | x<<16;    }
 void tonccpya(void *dst, const void *src, uint size);
 void tonccpy(void *dst, const void *src, uint size);
 
+#else
+
+//# Host builds copy with the C library (tonccpy.cpp assumes 32-bit pointers).
+
+#include <string.h>
+
+typedef unsigned int uint;
+
+static inline void tonccpya(void *dst, const void *src, uint size) { memmove(dst, src, size); }
+static inline void tonccpy(void *dst, const void *src, uint size) { memmove(dst, src, size); }
+
+#endif
+
 #ifdef __cplusplus
 }
 #endif